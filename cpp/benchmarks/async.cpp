@@ -0,0 +1,98 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Overlap of the caller's own work with the pool's work.  The caller
+// prepares the next input (a serial loop) while the pool processes the
+// current one; execute runs the two one after the other, execute_async
+// overlaps them.
+//
+// Usage: async_benchmark [max_threads] [num_elements]
+
+#include "sysml/measure.hpp"
+#include "sysml/thread/cpu_pool.hpp"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    using namespace sysml::thread;
+
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    std::size_t n           = 1 << 18;
+
+    if (argc > 1)
+    {
+        max_threads = std::stoul(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        n = std::stoul(argv[2]);
+    }
+
+    std::vector<float> current(n, 1.f);
+    std::vector<float> next(n, 1.f);
+
+    std::printf("elements: %zu\n", n);
+    std::printf("%8s %14s %14s %14s %14s\n", "threads", "prepare", "execute",
+                "sequential", "async");
+
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t t = 2; t < max_threads; t *= 2)
+    {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(std::max(max_threads, std::size_t(2)));
+
+    for (auto threads : thread_counts)
+    {
+        cpu_pool pool(threads);
+
+        std::size_t const blocks = 4 * (threads - 1);
+
+        auto process = [&](cpu_context const&, std::size_t b)
+        {
+            for (std::size_t i = n * b / blocks; i < n * (b + 1) / blocks; ++i)
+            {
+                current[i] = current[i] * 0.999f + 0.001f;
+            }
+        };
+
+        auto prepare = [&]()
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                next[i] = next[i] * 0.5f + 0.25f;
+            }
+        };
+
+        auto measure = [&](auto&& fn)
+        { return sysml::measure_median(fn, 51, 5) * 1e6; };
+
+        double prepare_only = measure(prepare);
+        double execute_only = measure([&]() { pool.execute(process, blocks); });
+
+        double sequential = measure(
+            [&]()
+            {
+                pool.execute(process, blocks);
+                prepare();
+            });
+
+        double async = measure(
+            [&]()
+            {
+                auto handle = pool.execute_async(process, blocks);
+                prepare();
+                handle.wait();
+            });
+
+        std::printf("%8zu %12.3fus %12.3fus %12.3fus %12.3fus\n", threads,
+                    prepare_only, execute_only, sequential, async);
+    }
+}
@@ -0,0 +1,118 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Barrier round-trip latency as a function of the number of threads,
+// and the resulting cpu_pool dispatch latency (empty execute).
+//
+// Usage: barrier_benchmark [max_threads] [rounds]
+
+#include "sysml/measure.hpp"
+#include "sysml/thread/barrier.hpp"
+#include "sysml/thread/cpu_pool.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Average time of a single arrive_and_wait, measured on the first
+// participant.
+template <class Barrier, class... Args>
+double barrier_round_trip(std::size_t num_threads, std::size_t rounds,
+                          Args&&... args)
+{
+    Barrier barrier(std::forward<Args>(args)...);
+
+    auto participant = [&](std::size_t idx)
+    {
+        for (std::size_t r = 0; r < rounds; ++r)
+        {
+            sysml::thread::arrive_and_wait(barrier, idx);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < num_threads; ++i)
+    {
+        threads.emplace_back(participant, i);
+    }
+
+    // Get everyone started before measuring.
+    sysml::thread::arrive_and_wait(barrier, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    participant(0);
+    auto end = std::chrono::steady_clock::now();
+
+    sysml::thread::arrive_and_wait(barrier, 0);
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    return std::chrono::duration<double>(end - start).count() /
+           static_cast<double>(rounds);
+}
+
+template <class Pool>
+double empty_execute(std::size_t num_threads)
+{
+    Pool pool(num_threads);
+    return sysml::measure_median(
+        [&]() { pool.execute_on_all_cpus([](auto const&) {}); }, 1001, 100);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace sysml::thread;
+
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    std::size_t rounds      = 100000;
+
+    if (argc > 1)
+    {
+        max_threads = std::stoul(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        rounds = std::stoul(argv[2]);
+    }
+
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t t = 1; t < max_threads; t *= 2)
+    {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::printf("%8s %12s %12s %12s %12s %14s %14s %14s\n", "threads",
+                "spinning", "tree", "hybrid", "default", "pool_spinning",
+                "pool_tree", "pool_hybrid");
+
+    for (auto n : thread_counts)
+    {
+        auto spinning = barrier_round_trip<spinning_barrier>(n, rounds, n);
+        auto tree     = barrier_round_trip<tree_barrier>(n, rounds, n);
+        auto hybrid   = barrier_round_trip<hybrid_barrier>(n, rounds, n);
+        auto deflt    = barrier_round_trip<default_barrier>(n, rounds, n);
+
+        auto pool_spinning = empty_execute<cpu_pool>(n);
+        auto pool_tree     = empty_execute<basic_cpu_pool<tree_barrier>>(n);
+        auto pool_hybrid   = empty_execute<basic_cpu_pool<hybrid_barrier>>(n);
+
+        std::printf("%8zu %10.3fus %10.3fus %10.3fus %10.3fus %12.3fus "
+                    "%12.3fus %12.3fus\n",
+                    n, spinning * 1e6, tree * 1e6, hybrid * 1e6, deflt * 1e6,
+                    pool_spinning * 1e6, pool_tree * 1e6, pool_hybrid * 1e6);
+    }
+}
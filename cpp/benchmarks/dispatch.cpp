@@ -0,0 +1,211 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Dispatch and synchronization latencies of sysml::thread, for a sweep
+// of thread counts and worker placements:
+//
+//   execute               empty execute(fn, size()) round trip
+//   execute_on_all_cpus   empty execute_on_all_cpus round trip
+//   *_barrier             arrive_and_wait latency inside a task
+//   sleep_to_spin         to_spinning_mode() from sleeping mode
+//   parallel_for_*        parallel_for cost per (empty) iteration
+//
+// Every call is timed with sysml::measure and the samples summarized
+// with compute_statistics, as sysml_bench does.  Results are written as
+// CSV to stdout, one row per benchmark, with the min, median and 90th
+// percentile of the samples.  Placements the machine has not enough
+// cpus for are skipped.
+//
+// Usage: dispatch_benchmark [max_threads] [samples]
+
+#include "sysml/measure.hpp"
+#include "sysml/thread/barrier.hpp"
+#include "sysml/thread/cpu_pool.hpp"
+#include "sysml/thread/parallel_for.hpp"
+#include "sysml/thread/placement.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace sysml::thread;
+
+// Times every call of fn after a few warm up calls; in seconds.
+template <class Fn>
+sysml::measurement_statistics sample(Fn&& fn, std::size_t samples)
+{
+    return sysml::measure_statistics(
+        fn, static_cast<unsigned>(samples),
+        static_cast<unsigned>(std::min<std::size_t>(samples / 10 + 1, 100)));
+}
+
+void emit(char const* benchmark, std::string const& placement,
+          std::size_t threads, char const* unit, double scale,
+          sysml::measurement_statistics const& s)
+{
+    std::printf("%s,%s,%zu,%s,%.4f,%.4f,%.4f\n", benchmark, placement.c_str(),
+                threads, unit, s.min * scale, s.median * scale,
+                s.p90 * scale);
+}
+
+std::unique_ptr<cpu_pool> make_pool(std::string const& placement,
+                                    std::size_t        threads)
+{
+    if (placement == "compact")
+    {
+        return std::make_unique<cpu_pool>(threads, compact_placement{});
+    }
+    if (placement == "scatter")
+    {
+        return std::make_unique<cpu_pool>(threads, scatter_placement{});
+    }
+    return std::make_unique<cpu_pool>(threads);
+}
+
+constexpr std::size_t barrier_rounds = 100;
+
+// Time of barrier_rounds arrive_and_waits of the barrier, with every
+// worker of the pool taking part.
+template <class Barrier>
+sysml::measurement_statistics
+barrier_latency(cpu_pool& pool, Barrier& barrier, std::size_t samples)
+{
+    return sample(
+        [&]()
+        {
+            pool.execute_on_all_cpus(
+                [&](cpu_context const& ctx)
+                {
+                    for (std::size_t r = 0; r < barrier_rounds; ++r)
+                    {
+                        arrive_and_wait(barrier, ctx.cpu_index);
+                    }
+                });
+        },
+        samples / 10 + 1);
+}
+
+void run(std::string const& placement, std::size_t threads,
+         std::size_t samples)
+{
+    auto  pool_ptr = make_pool(placement, threads);
+    auto& pool     = *pool_ptr;
+
+    auto empty_task = [](cpu_context const&, std::size_t) {};
+    auto empty_all  = [](cpu_context const&) {};
+
+    emit("execute", placement, threads, "us", 1e6,
+         sample([&]() { pool.execute(empty_task, pool.size()); }, samples));
+
+    emit("execute_on_all_cpus", placement, threads, "us", 1e6,
+         sample([&]() { pool.execute_on_all_cpus(empty_all); }, samples));
+
+    {
+        spinning_barrier barrier(threads);
+        emit("spinning_barrier", placement, threads, "us",
+             1e6 / barrier_rounds, barrier_latency(pool, barrier, samples));
+    }
+
+    {
+        default_barrier barrier(threads);
+        emit("default_barrier", placement, threads, "us",
+             1e6 / barrier_rounds, barrier_latency(pool, barrier, samples));
+    }
+
+    {
+        auto barrier = pool.cpu_ids().empty() ? tree_barrier(threads)
+                                              : tree_barrier(pool.cpu_ids());
+        emit("tree_barrier", placement, threads, "us",
+             1e6 / barrier_rounds, barrier_latency(pool, barrier, samples));
+    }
+
+    {
+        hybrid_barrier barrier(threads);
+        emit("hybrid_barrier", placement, threads, "us",
+             1e6 / barrier_rounds, barrier_latency(pool, barrier, samples));
+    }
+
+    {
+        // The workers are given time to fall asleep before every wake.
+        std::vector<double> wakes;
+        for (std::size_t i = 0; i < samples / 10 + 1; ++i)
+        {
+            pool.to_sleeping_mode();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+            wakes.push_back(
+                sysml::measure_fastest([&]() { pool.to_spinning_mode(); }));
+        }
+        emit("sleep_to_spin", placement, threads, "us", 1e6,
+             sysml::compute_statistics(std::move(wakes)));
+    }
+
+    {
+        constexpr int n = 1 << 16;
+
+        auto body = [](int) {};
+
+        emit("parallel_for_static", placement, threads, "ns", 1e9 / n,
+             sample([&]()
+                    { parallel_for(pool, 0, n, 1, body,
+                                   static_block_schedule{}); },
+                    samples / 10 + 1));
+
+        emit("parallel_for_dynamic", placement, threads, "ns", 1e9 / n,
+             sample([&]()
+                    { parallel_for(pool, 0, n, 1, body,
+                                   dynamic_schedule{256}); },
+                    samples / 10 + 1));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    std::size_t samples     = 1000;
+
+    if (argc > 1)
+    {
+        max_threads = std::stoul(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        samples = std::max<std::size_t>(std::stoul(argv[2]), 1);
+    }
+
+    std::size_t const available = available_cpu_topology().size();
+
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t t = 1; t < max_threads; t *= 2)
+    {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::printf("benchmark,placement,threads,unit,min,median,p90\n");
+
+    for (auto threads : thread_counts)
+    {
+        for (std::string placement : {"unbound", "compact", "scatter"})
+        {
+            if (placement != "unbound" && threads > available)
+            {
+                continue;
+            }
+
+            run(placement, threads, samples);
+        }
+    }
+}
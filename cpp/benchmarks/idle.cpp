@@ -0,0 +1,161 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Wake-up latency of cpu_pool for the ways of idling between executes:
+// spinning, explicit sleeping mode, and parking by the idle policy.
+// The caller waits for a gap (busy waiting, so that its own cpu stays
+// awake), then issues an empty execute.  Reports the median latency of
+// the execute and the cpu time the workers used, as a fraction of
+// their cpus.
+//
+// Usage: idle_benchmark [threads] [rounds]
+
+#include "sysml/thread/cpu_pool.hpp"
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace std::chrono_literals;
+
+double cpu_seconds(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<double>(ts.tv_sec) +
+           static_cast<double>(ts.tv_nsec) * 1e-9;
+}
+
+void busy_wait(std::chrono::nanoseconds gap)
+{
+    auto const until = std::chrono::steady_clock::now() + gap;
+    while (std::chrono::steady_clock::now() < until)
+    {
+    }
+}
+
+struct result
+{
+    double latency;
+    double worker_load;
+};
+
+result measure_wake_up(sysml::thread::cpu_pool& pool,
+                       std::chrono::nanoseconds gap, std::size_t rounds)
+{
+    auto empty = [](sysml::thread::cpu_context const&) {};
+
+    // Warm up, and let the adaptive policy settle.
+    for (std::size_t r = 0; r < 20; ++r)
+    {
+        busy_wait(gap);
+        pool.execute_on_all_cpus(empty);
+    }
+
+    std::vector<double> latencies;
+
+    double const process_start = cpu_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    double const owner_start   = cpu_seconds(CLOCK_THREAD_CPUTIME_ID);
+    auto const   wall_start    = std::chrono::steady_clock::now();
+
+    for (std::size_t r = 0; r < rounds; ++r)
+    {
+        busy_wait(gap);
+
+        auto start = std::chrono::steady_clock::now();
+        pool.execute_on_all_cpus(empty);
+        auto end = std::chrono::steady_clock::now();
+
+        latencies.push_back(std::chrono::duration<double>(end - start).count());
+    }
+
+    std::chrono::duration<double> const wall =
+        std::chrono::steady_clock::now() - wall_start;
+
+    double const workers_cpu =
+        (cpu_seconds(CLOCK_PROCESS_CPUTIME_ID) - process_start) -
+        (cpu_seconds(CLOCK_THREAD_CPUTIME_ID) - owner_start);
+
+    std::nth_element(latencies.begin(),
+                     latencies.begin() + latencies.size() / 2,
+                     latencies.end());
+
+    return {latencies[latencies.size() / 2],
+            workers_cpu /
+                (wall.count() * static_cast<double>(pool.size() - 1))};
+}
+
+struct idle_mode
+{
+    char const*                                   name;
+    std::function<void(sysml::thread::cpu_pool&)> setup;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace sysml::thread;
+
+    std::size_t threads = std::max(std::thread::hardware_concurrency(), 2u);
+    std::size_t rounds  = 200;
+
+    if (argc > 1)
+    {
+        threads = std::max(std::stoul(argv[1]), 2ul);
+    }
+
+    if (argc > 2)
+    {
+        rounds = std::stoul(argv[2]);
+    }
+
+    std::vector<idle_mode> modes = {
+        {"spin", [](cpu_pool& p) { p.set_idle_policy(idle_policy{}); }},
+        {"sleeping_mode", [](cpu_pool& p) { p.to_sleeping_mode(); }},
+        {"park_0us",
+         [](cpu_pool& p) { p.set_idle_policy(idle_policy::park_after(0us)); }},
+        {"park_50us",
+         [](cpu_pool& p) { p.set_idle_policy(idle_policy::park_after(50us)); }},
+        {"adaptive",
+         [](cpu_pool& p) { p.set_idle_policy(idle_policy::adaptive_park()); }},
+    };
+
+    std::vector<std::chrono::nanoseconds> gaps = {0us, 10us, 100us, 1ms};
+
+    std::printf("threads: %zu\n", threads);
+    std::printf("%14s", "gap");
+    for (auto const& m : modes)
+    {
+        std::printf(" %22s", m.name);
+    }
+    std::printf("\n");
+
+    for (auto gap : gaps)
+    {
+        std::printf("%12.0fus", static_cast<double>(gap.count()) * 1e-3);
+
+        for (auto const& m : modes)
+        {
+            cpu_pool pool(threads);
+            m.setup(pool);
+
+            auto r = measure_wake_up(pool, gap, rounds);
+            std::printf(" %10.2fus (%5.1f%% cpu)", r.latency * 1e6,
+                        r.worker_load * 100);
+        }
+
+        std::printf("\n");
+    }
+}
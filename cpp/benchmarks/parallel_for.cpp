@@ -0,0 +1,84 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Compares the parallel_for flavors on loops with skewed per-iteration
+// costs.
+//
+// Usage: parallel_for_benchmark [num_threads] [num_iterations]
+
+#include "sysml/measure.hpp"
+#include "sysml/thread/parallel_for.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+__attribute__((noinline)) void spin_work(int amount)
+{
+    for (int i = 0; i < amount; ++i)
+    {
+        asm volatile("" ::: "memory");
+    }
+}
+
+struct skew
+{
+    char const* name;
+    int (*cost)(int i, int n);
+};
+
+skew const skews[] = {
+    {"uniform", [](int, int) { return 200; }},
+    {"triangular", [](int i, int n) { return 400 * i / n; }},
+    {"one_heavy_in_64", [](int i, int) { return i % 64 == 0 ? 6400 : 100; }},
+    {"heavy_tail", [](int i, int n) { return i > n - n / 16 ? 3200 : 50; }},
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace sysml::thread;
+
+    std::size_t num_threads = std::thread::hardware_concurrency();
+    int         n           = 1 << 14;
+
+    if (argc > 1)
+    {
+        num_threads = std::stoul(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        n = std::stoi(argv[2]);
+    }
+
+    cpu_pool pool(num_threads);
+
+    std::printf("threads: %zu iterations: %d\n", num_threads, n);
+    std::printf("%-18s %14s %14s %14s\n", "skew", "naive", "single_queue",
+                "dynamic");
+
+    for (auto const& s : skews)
+    {
+        auto body = [&](int i) { spin_work(s.cost(i, n)); };
+
+        double naive = sysml::measure_median(
+            [&]() { naive_parallel_for(pool, 0, n, 1, body); }, 21);
+
+        double single_queue = sysml::measure_median(
+            [&]() { single_queue_parallel_for(pool, 0, n, 1, body); }, 21);
+
+        double dynamic = sysml::measure_median(
+            [&]() { parallel_for_dynamic(pool, 0, n, 1, body); }, 21);
+
+        std::printf("%-18s %12.3fus %12.3fus %12.3fus\n", s.name, naive * 1e6,
+                    single_queue * 1e6, dynamic * 1e6);
+    }
+}
@@ -0,0 +1,92 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Compares the parallel_for scheduling policies on a fine grained loop
+// body, for a range of thread counts.
+//
+// Usage: schedules_benchmark [max_threads] [num_iterations]
+
+#include "sysml/measure.hpp"
+#include "sysml/thread/parallel_for.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    using namespace sysml::thread;
+
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    int         n           = 1 << 16;
+
+    if (argc > 1)
+    {
+        max_threads = std::stoul(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        n = std::stoi(argv[2]);
+    }
+
+    std::vector<float> data(n, 1.f);
+
+    auto body = [&](int i) { data[i] = data[i] * 0.999f + 0.001f; };
+
+    std::printf("iterations: %d\n", n);
+    std::printf("%8s %14s %14s %14s %14s %14s %14s\n", "threads",
+                "single_queue", "static_block", "chunked_256", "guided",
+                "dynamic_256", "affinity");
+
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t t = 1; t < max_threads; t *= 2)
+    {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(max_threads);
+
+    for (auto threads : thread_counts)
+    {
+        cpu_pool pool(threads);
+
+        auto measure = [&](auto&& fn)
+        { return sysml::measure_median(fn, 51, 5) * 1e6; };
+
+        double single_queue = measure(
+            [&]() { single_queue_parallel_for(pool, 0, n, 1, body); });
+
+        double static_block = measure(
+            [&]()
+            { parallel_for(pool, 0, n, 1, body, static_block_schedule{}); });
+
+        double chunked = measure(
+            [&]()
+            { parallel_for(pool, 0, n, 1, body, chunked_schedule{256}); });
+
+        double guided = measure(
+            [&]() { parallel_for(pool, 0, n, 1, body, guided_schedule{16}); });
+
+        double dynamic = measure(
+            [&]()
+            { parallel_for(pool, 0, n, 1, body, dynamic_schedule{256}); });
+
+        // Same loop every time, so the chunks stay with their workers.
+        loop_affinity affinity;
+        double        affine = measure(
+            [&]()
+            {
+                parallel_for(pool, 0, n, 1, body,
+                             affinity_schedule{&affinity});
+            });
+
+        std::printf(
+            "%8zu %12.3fus %12.3fus %12.3fus %12.3fus %12.3fus %12.3fus\n",
+            threads, single_queue, static_block, chunked, guided, dynamic,
+            affine);
+    }
+}
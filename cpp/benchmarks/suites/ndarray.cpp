@@ -0,0 +1,74 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "sysml/measure/benchmark.hpp"
+#include "sysml/ndarray.hpp"
+
+#include <cstddef>
+
+namespace
+{
+
+constexpr std::size_t n = 512;
+
+sysml::ndarray<float, 2> make_matrix()
+{
+    sysml::ndarray<float, 2> ret({n, n});
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            ret[i][j] = static_cast<float>(i + j);
+        }
+    }
+
+    return ret;
+}
+
+volatile float sink;
+
+} // namespace
+
+SYSML_BENCHMARK(ndarray_sum_rows)
+{
+    auto a = make_matrix();
+
+    bench.set_items(n * n);
+    bench.measure(
+        [&]
+        {
+            float sum = 0.f;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                for (std::size_t j = 0; j < n; ++j)
+                {
+                    sum += a[i][j];
+                }
+            }
+            sink = sum;
+        });
+}
+
+// Strided accesses, for the cost of walking the array the wrong way.
+SYSML_BENCHMARK(ndarray_sum_columns)
+{
+    auto a = make_matrix();
+
+    bench.set_items(n * n);
+    bench.measure(
+        [&]
+        {
+            float sum = 0.f;
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    sum += a[i][j];
+                }
+            }
+            sink = sum;
+        });
+}
@@ -0,0 +1,87 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "sysml/measure/benchmark.hpp"
+#include "sysml/thread/barrier.hpp"
+#include "sysml/thread/cpu_pool.hpp"
+#include "sysml/thread/parallel_for.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+namespace
+{
+
+using namespace sysml::thread;
+
+std::size_t num_threads()
+{
+    return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+// A pool of num_threads() workers free to run on all the cpus, also
+// when the runner is bound to one with --cpu.
+cpu_pool make_pool(sysml::benchmark_context const& bench)
+{
+    return bench.unbound([] { return cpu_pool(num_threads()); });
+}
+
+} // namespace
+
+SYSML_BENCHMARK(cpu_pool_execute_empty)
+{
+    cpu_pool pool = make_pool(bench);
+
+    bench.measure(
+        [&]
+        { pool.execute([](cpu_context const&, std::size_t) {}, pool.size()); });
+}
+
+SYSML_BENCHMARK(cpu_pool_spinning_barrier)
+{
+    constexpr int rounds = 100;
+
+    cpu_pool         pool = make_pool(bench);
+    spinning_barrier barrier(pool.size());
+
+    bench.set_items(rounds);
+    bench.measure(
+        [&]
+        {
+            pool.execute_on_all_cpus(
+                [&](cpu_context const&)
+                {
+                    for (int r = 0; r < rounds; ++r)
+                    {
+                        barrier.arrive_and_wait();
+                    }
+                });
+        });
+}
+
+SYSML_BENCHMARK(parallel_for_static)
+{
+    constexpr int n = 1 << 16;
+
+    cpu_pool pool = make_pool(bench);
+
+    bench.set_items(n);
+    bench.measure([&]
+                  { parallel_for(pool, 0, n, 1, [](int) {},
+                                 static_block_schedule{}); });
+}
+
+SYSML_BENCHMARK(parallel_for_dynamic)
+{
+    constexpr int n = 1 << 16;
+
+    cpu_pool pool = make_pool(bench);
+
+    bench.set_items(n);
+    bench.measure([&]
+                  { parallel_for(pool, 0, n, 1, [](int) {},
+                                 dynamic_schedule{256}); });
+}
@@ -0,0 +1,22 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Runs the benchmarks registered with SYSML_BENCHMARK in suites/.
+//
+// Usage: sysml_bench [--filter=REGEX] [--repetitions=N] [--seconds=S]
+//                    [--min_iterations=N] [--max_iterations=N]
+//                    [--timer=steady|tsc|precise] [--cpu=N]
+//                    [--format=text|csv|json] [--list]
+//                    [--baseline=FILE [--alpha=P] [--threshold=R]]
+//
+// With --baseline, the run is compared with the json results of an
+// earlier one; the exit code is 2 when a benchmark regressed.  --timer
+// picks the clock the runs are timed with (steady by default).  --cpu
+// binds the runner thread only; the thread suites start their pools
+// with the affinity it had before.
+
+#include "sysml/measure/benchmark.hpp"
+
+int main(int argc, char* argv[]) { return sysml::benchmark_main(argc, argv); }
@@ -0,0 +1,136 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// A pipeline of stages, each made of independent kernels of uneven
+// cost; kernel k of a stage depends on kernels k and k + 1 of the
+// previous one.  Compares one execute per stage (a full barrier
+// between stages) with replaying the same pipeline as a task_graph.
+//
+// Usage: task_graph_benchmark [max_threads] [stages] [kernels]
+
+#include "sysml/measure.hpp"
+#include "sysml/thread/cpu_pool.hpp"
+#include "sysml/thread/task_graph.hpp"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Work proportional to n, kept alive by writing to a buffer.
+void kernel(std::vector<float>& buffer, std::size_t n)
+{
+    float x = buffer[0];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x = x * 0.999f + 0.001f;
+    }
+    buffer[0] = x;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace sysml::thread;
+
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    std::size_t stages      = 16;
+    std::size_t kernels     = 64;
+
+    if (argc > 1)
+    {
+        max_threads = std::stoul(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        stages = std::stoul(argv[2]);
+    }
+
+    if (argc > 3)
+    {
+        kernels = std::stoul(argv[3]);
+    }
+
+    // Kernel costs between 1x and 8x of the cheapest one.
+    std::mt19937                          rng(0);
+    std::uniform_int_distribution<int>    scale(1, 8);
+    std::vector<std::vector<std::size_t>> cost(
+        stages, std::vector<std::size_t>(kernels));
+    for (auto& s : cost)
+    {
+        for (auto& c : s)
+        {
+            c = 1000 * scale(rng);
+        }
+    }
+
+    std::vector<std::vector<float>> buffers(stages * kernels,
+                                            std::vector<float>(16, 1.f));
+
+    auto run_kernel = [&](std::size_t s, std::size_t k)
+    { kernel(buffers[s * kernels + k], cost[s][k]); };
+
+    std::printf("stages: %zu, kernels per stage: %zu\n", stages, kernels);
+    std::printf("%8s %14s %14s %10s\n", "threads", "per_stage", "task_graph",
+                "speedup");
+
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t t = 1; t < max_threads; t *= 2)
+    {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(max_threads);
+
+    for (auto threads : thread_counts)
+    {
+        cpu_pool pool(threads);
+
+        auto per_stage = [&]()
+        {
+            for (std::size_t s = 0; s < stages; ++s)
+            {
+                pool.execute([&](cpu_context const&, std::size_t k)
+                             { run_kernel(s, k); },
+                             kernels);
+            }
+        };
+
+        task_graph graph;
+        for (std::size_t s = 0; s < stages; ++s)
+        {
+            for (std::size_t k = 0; k < kernels; ++k)
+            {
+                std::vector<task_graph::node_id> dependencies;
+                if (s > 0)
+                {
+                    auto const prev = (s - 1) * kernels;
+                    dependencies.push_back(
+                        static_cast<task_graph::node_id>(prev + k));
+                    if (k + 1 < kernels)
+                    {
+                        dependencies.push_back(
+                            static_cast<task_graph::node_id>(prev + k + 1));
+                    }
+                }
+                graph.add([&run_kernel, s, k] { run_kernel(s, k); },
+                          dependencies);
+            }
+        }
+
+        auto graph_run = [&]() { execute_graph(pool, graph); };
+
+        double t_stage = sysml::measure_median(per_stage, 51, 5) * 1e6;
+        double t_graph = sysml::measure_median(graph_run, 51, 5) * 1e6;
+
+        std::printf("%8zu %12.2fus %12.2fus %9.2fx\n", threads, t_stage,
+                    t_graph, t_stage / t_graph);
+    }
+}
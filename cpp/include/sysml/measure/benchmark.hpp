@@ -0,0 +1,891 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/assert.hpp"
+#include "sysml/measure/measure.hpp"
+#include "sysml/measure/statistics.hpp"
+#include "sysml/thread/cpu_set.hpp"
+#include "sysml/utility.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A minimal benchmark harness.  Benchmarks are registered with
+//
+//   SYSML_BENCHMARK(name)
+//   {
+//       ... setup, not timed ...
+//       bench.set_items(n);          // Optional, for a throughput column
+//       bench.measure([&] { ... });  // Timed
+//   }
+//
+// and run by benchmark_main(), usually from an executable built out of
+// any number of such files (see sysml_bench in benchmarks/).
+//
+// The json output keeps the samples of every benchmark, and can be
+// given back as --baseline=FILE to compare a later run against it.
+
+namespace sysml
+{
+
+struct benchmark_options
+{
+    // ECMAScript regex searched for in the names; empty runs all.
+    std::string filter;
+
+    // Samples per benchmark, each taking about seconds.
+    unsigned repetitions = 5;
+    double   seconds     = 0.1;
+
+    std::size_t min_iterations = 1;
+    std::size_t max_iterations = std::numeric_limits<std::size_t>::max();
+
+    // The measure timer: steady, tsc (where supported) or precise (see
+    // sysml/measure/clock.hpp).
+    std::string timer = "steady";
+
+    // The runner is bound to this cpu, unless it's -1.  Threads started
+    // by the benchmarks inherit the binding, unless they are started in
+    // benchmark_context::unbound().
+    int cpu = -1;
+
+    std::string format = "text"; // text, csv or json
+    bool        list   = false;  // Only print the names
+
+    // Json results of an earlier run to compare with.  A benchmark
+    // regressed when its times are larger with a (two-sided)
+    // Mann-Whitney p-value below alpha, and its median slowed down by
+    // more than threshold (relative); improvements likewise.
+    std::string baseline;
+    double      alpha     = 0.05;
+    double      threshold = 0.05;
+};
+
+struct benchmark_result
+{
+    std::string name;
+    double      items = 0.0; // Per run, 0 when not set
+
+    // Seconds per run; a sample per repetition, each the mean of a
+    // batch of runs.  The samples are kept.
+    measurement_statistics seconds;
+
+    double items_per_second() const
+    {
+        return seconds.median > 0.0 ? items / seconds.median : 0.0;
+    }
+};
+
+class benchmark_context
+{
+private:
+    benchmark_options const& options_;
+    benchmark_result&        result_;
+    thread::cpu_set const&   runner_affinity_; // Before the --cpu binding
+    bool                     measured_ = false;
+
+public:
+    benchmark_context(benchmark_options const& options,
+                      benchmark_result&        result,
+                      thread::cpu_set const&   runner_affinity)
+        : options_(options)
+        , result_(result)
+        , runner_affinity_(runner_affinity)
+    {
+    }
+
+    // Calls fn with the runner's affinity from before the --cpu binding,
+    // and returns its result.  The threads fn starts, e.g. the workers of
+    // a pool, can then run on all those cpus rather than the one:
+    //
+    //   cpu_pool pool = bench.unbound([] { return cpu_pool(n); });
+    template <class Fn>
+    std::invoke_result_t<Fn&> unbound(Fn&& fn) const
+    {
+        if (options_.cpu == -1)
+        {
+            return fn();
+        }
+
+        thread::cpu_set bound;
+        thread::get_affinity(bound);
+        thread::set_affinity(runner_affinity_);
+
+        scope_exit_guard restore([&] { thread::set_affinity(bound); });
+
+        return fn();
+    }
+
+    // Items (elements, bytes, tasks...) processed per run of the
+    // measured function.
+    void set_items(double n) { result_.items = n; }
+
+    // Times fn; each repetition runs it for about the time budget (see
+    // measure_mean_timed_and_bounded).  Called once per benchmark.
+    template <class Fn>
+    void measure(Fn&& fn)
+    {
+        SYSML_THROW_ASSERT(!measured_)
+            << "Benchmark " << result_.name << " measured more than once";
+
+        std::vector<double> samples(std::max(options_.repetitions, 1u));
+
+        auto const sample = [&](auto timer)
+        {
+            using timer_type = decltype(timer);
+            for (auto& s : samples)
+            {
+                s = measure_mean_timed_and_bounded<timer_type>(
+                    fn, options_.seconds, options_.min_iterations,
+                    options_.max_iterations);
+            }
+        };
+
+        if (options_.timer == "precise")
+        {
+            sample(precise_timer{});
+        }
+#if defined(SYSML_ON_ARCH_AMD64)
+        else if (options_.timer == "tsc")
+        {
+            sample(tsc_timer{});
+        }
+#endif
+        else
+        {
+            sample(steady_timer{});
+        }
+
+        result_.seconds = compute_statistics(std::move(samples), {true});
+        measured_       = true;
+    }
+
+    bool measured() const noexcept { return measured_; }
+};
+
+using benchmark_function = void (*)(benchmark_context&);
+
+struct registered_benchmark
+{
+    std::string        name;
+    benchmark_function function;
+};
+
+inline std::vector<registered_benchmark>& benchmark_registry()
+{
+    static std::vector<registered_benchmark> registry;
+    return registry;
+}
+
+inline bool register_benchmark(std::string name, benchmark_function fn)
+{
+    auto& registry = benchmark_registry();
+
+    SYSML_THROW_ASSERT(std::none_of(registry.begin(), registry.end(),
+                                    [&](registered_benchmark const& b)
+                                    { return b.name == name; }))
+        << "Benchmark " << name << " registered twice";
+
+    registry.push_back({std::move(name), fn});
+    return true;
+}
+
+#define SYSML_BENCHMARK(name)                                                  \
+    static void sysml_benchmark_##name(::sysml::benchmark_context&);           \
+    [[maybe_unused]] static bool const SYSML_UNIQUE_VARIABLE_NAME(             \
+        sysml_benchmark_registered_) =                                         \
+        ::sysml::register_benchmark(#name, &sysml_benchmark_##name);           \
+    static void sysml_benchmark_##name(                                        \
+        [[maybe_unused]] ::sysml::benchmark_context& bench)
+
+// The registered benchmarks matching the filter, sorted by name.
+inline std::vector<registered_benchmark>
+selected_benchmarks(benchmark_options const& options)
+{
+    std::regex const                  filter(options.filter);
+    std::vector<registered_benchmark> ret;
+
+    for (auto const& b : benchmark_registry())
+    {
+        if (std::regex_search(b.name, filter))
+        {
+            ret.push_back(b);
+        }
+    }
+
+    std::sort(ret.begin(), ret.end(),
+              [](registered_benchmark const& a, registered_benchmark const& b)
+              { return a.name < b.name; });
+
+    return ret;
+}
+
+inline std::vector<benchmark_result>
+run_benchmarks(benchmark_options const& options)
+{
+    thread::cpu_set runner_affinity;
+    thread::get_affinity(runner_affinity);
+
+    if (options.cpu != -1)
+    {
+        thread::bind_to_core(options.cpu);
+    }
+
+    scope_exit_guard unbind(
+        [&]
+        {
+            if (options.cpu != -1)
+            {
+                thread::set_affinity(runner_affinity);
+            }
+        });
+
+    std::vector<benchmark_result> ret;
+
+    for (auto const& b : selected_benchmarks(options))
+    {
+        benchmark_result result;
+        result.name = b.name;
+
+        benchmark_context context(options, result, runner_affinity);
+
+        b.function(context);
+
+        SYSML_THROW_ASSERT(context.measured())
+            << "Benchmark " << b.name << " measured nothing";
+
+        ret.push_back(std::move(result));
+    }
+
+    return ret;
+}
+
+namespace detail
+{
+
+inline std::string format_benchmark_time(double seconds)
+{
+    char const* unit  = "s";
+    double      value = seconds;
+
+    if (seconds < 1e-6)
+    {
+        unit  = "ns";
+        value = seconds * 1e9;
+    }
+    else if (seconds < 1e-3)
+    {
+        unit  = "us";
+        value = seconds * 1e6;
+    }
+    else if (seconds < 1.0)
+    {
+        unit  = "ms";
+        value = seconds * 1e3;
+    }
+
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f%s", value, unit);
+    return buffer;
+}
+
+inline std::string json_quote(std::string const& s)
+{
+    std::string ret = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            ret += '\\';
+        }
+        ret += c;
+    }
+    return ret + "\"";
+}
+
+} // namespace detail
+
+// Times are in seconds per run in the csv and json formats.
+inline void
+write_benchmark_results(std::ostream&                        os,
+                        std::vector<benchmark_result> const& results,
+                        std::string const&                   format)
+{
+    char buffer[512];
+
+    if (format == "csv")
+    {
+        os << "name,repetitions,min,median,mean,max,stddev,cv,"
+              "items_per_second\n";
+        for (auto const& r : results)
+        {
+            auto const& s = r.seconds;
+            std::snprintf(buffer, sizeof(buffer),
+                          ",%zu,%.6e,%.6e,%.6e,%.6e,%.6e,%.4f,%.6e\n", s.count,
+                          s.min, s.median, s.mean, s.max, s.stddev, s.cv,
+                          r.items_per_second());
+            os << r.name << buffer;
+        }
+    }
+    else if (format == "json")
+    {
+        os << "{\n  \"benchmarks\": [";
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            auto const& r = results[i];
+            auto const& s = r.seconds;
+            std::snprintf(buffer, sizeof(buffer),
+                          ", \"repetitions\": %zu, \"min\": %.6e, "
+                          "\"median\": %.6e, \"mean\": %.6e, \"max\": %.6e, "
+                          "\"stddev\": %.6e, \"cv\": %.4f, "
+                          "\"items_per_second\": %.6e, \"samples\": [",
+                          s.count, s.min, s.median, s.mean, s.max, s.stddev,
+                          s.cv, r.items_per_second());
+            os << (i ? "," : "") << "\n    {\"name\": "
+               << detail::json_quote(r.name) << buffer;
+
+            for (std::size_t j = 0; j < s.samples.size(); ++j)
+            {
+                std::snprintf(buffer, sizeof(buffer), "%s%.6e", j ? ", " : "",
+                              s.samples[j]);
+                os << buffer;
+            }
+            os << "]}";
+        }
+        os << "\n  ]\n}\n";
+    }
+    else
+    {
+        SYSML_THROW_ASSERT(format == "text")
+            << "Unknown benchmark output format " << format;
+
+        std::size_t width = 4;
+        for (auto const& r : results)
+        {
+            width = std::max(width, r.name.size());
+        }
+
+        std::snprintf(buffer, sizeof(buffer), "%-*s %12s %12s %8s %14s\n",
+                      static_cast<int>(width), "name", "median", "min", "cv",
+                      "items/s");
+        os << buffer;
+
+        for (auto const& r : results)
+        {
+            std::snprintf(buffer, sizeof(buffer), "%-*s %12s %12s %7.2f%%",
+                          static_cast<int>(width), r.name.c_str(),
+                          detail::format_benchmark_time(r.seconds.median)
+                              .c_str(),
+                          detail::format_benchmark_time(r.seconds.min).c_str(),
+                          r.seconds.cv * 100.0);
+            os << buffer;
+
+            if (r.items > 0.0)
+            {
+                std::snprintf(buffer, sizeof(buffer), " %14.4g",
+                              r.items_per_second());
+                os << buffer;
+            }
+
+            os << "\n";
+        }
+    }
+}
+
+struct benchmark_baseline_entry
+{
+    std::string         name;
+    std::vector<double> samples; // Seconds per run
+};
+
+namespace detail
+{
+
+// Just enough of a json tokenizer to read back the benchmark results.
+class json_tokenizer
+{
+private:
+    std::string const& text_;
+    std::size_t        pos_ = 0;
+
+public:
+    struct token
+    {
+        // '"' for strings (text unquoted), '0' for numbers, 'a' for
+        // literals, the character itself for punctuation, and 0 at the
+        // end.
+        char        kind = 0;
+        std::string text;
+    };
+
+    explicit json_tokenizer(std::string const& text)
+        : text_(text)
+    {
+    }
+
+    token next()
+    {
+        auto const is_space = [](char c)
+        { return c == ' ' || c == '\n' || c == '\t' || c == '\r'; };
+
+        while (pos_ < text_.size() && is_space(text_[pos_]))
+        {
+            ++pos_;
+        }
+
+        token ret;
+
+        if (pos_ == text_.size())
+        {
+            return ret;
+        }
+
+        char const c = text_[pos_];
+
+        if (c == '"')
+        {
+            ret.kind = '"';
+            for (++pos_; pos_ < text_.size() && text_[pos_] != '"'; ++pos_)
+            {
+                if (text_[pos_] == '\\' && pos_ + 1 < text_.size())
+                {
+                    ++pos_;
+                }
+                ret.text += text_[pos_];
+            }
+            ++pos_;
+        }
+        else if (std::string_view("+-.0123456789").find(c) !=
+                 std::string_view::npos)
+        {
+            ret.kind = '0';
+            while (pos_ < text_.size() &&
+                   std::string_view("+-.0123456789eE").find(text_[pos_]) !=
+                       std::string_view::npos)
+            {
+                ret.text += text_[pos_++];
+            }
+        }
+        else if (std::isalpha(static_cast<unsigned char>(c)))
+        {
+            ret.kind = 'a';
+            while (pos_ < text_.size() &&
+                   std::isalpha(static_cast<unsigned char>(text_[pos_])))
+            {
+                ret.text += text_[pos_++];
+            }
+        }
+        else
+        {
+            ret.kind = c;
+            ++pos_;
+        }
+
+        return ret;
+    }
+};
+
+} // namespace detail
+
+// Reads the samples of every benchmark back from the json results.
+// Only the "name" and "samples" members are looked at; benchmarks
+// without samples are left out.
+inline std::vector<benchmark_baseline_entry>
+read_benchmark_baseline(std::istream& is)
+{
+    std::string const      text(std::istreambuf_iterator<char>(is), {});
+    detail::json_tokenizer tokens(text);
+
+    std::vector<benchmark_baseline_entry> ret;
+
+    auto const expect = [&](char kind)
+    {
+        auto t = tokens.next();
+        SYSML_THROW_ASSERT(t.kind == kind)
+            << "Malformed benchmark baseline, expected " << kind
+            << " got " << t.text;
+        return t;
+    };
+
+    for (auto t = tokens.next(); t.kind != 0; t = tokens.next())
+    {
+        if (t.kind != '"')
+        {
+            continue;
+        }
+
+        if (t.text == "name")
+        {
+            expect(':');
+            ret.push_back({expect('"').text, {}});
+        }
+        else if (t.text == "samples")
+        {
+            SYSML_THROW_ASSERT(!ret.empty())
+                << "Malformed benchmark baseline, samples without a name";
+
+            expect(':');
+            expect('[');
+
+            for (auto v = tokens.next(); v.kind != ']'; v = tokens.next())
+            {
+                if (v.kind == '0')
+                {
+                    ret.back().samples.push_back(std::stod(v.text));
+                }
+                else
+                {
+                    SYSML_THROW_ASSERT(v.kind == ',')
+                        << "Malformed benchmark baseline samples";
+                }
+            }
+        }
+    }
+
+    ret.erase(std::remove_if(ret.begin(), ret.end(),
+                             [](benchmark_baseline_entry const& e)
+                             { return e.samples.empty(); }),
+              ret.end());
+
+    return ret;
+}
+
+inline std::vector<benchmark_baseline_entry>
+read_benchmark_baseline(std::string const& path)
+{
+    std::ifstream in(path);
+    SYSML_THROW_ASSERT(in.good()) << "Can't open benchmark baseline " << path;
+    return read_benchmark_baseline(in);
+}
+
+enum class benchmark_verdict
+{
+    unchanged,
+    regression,
+    improvement,
+    added,  // Not in the baseline
+    missing // In the baseline (and matching the filter) but not run
+};
+
+inline char const* to_string(benchmark_verdict v) noexcept
+{
+    switch (v)
+    {
+    case benchmark_verdict::unchanged:
+        return "unchanged";
+    case benchmark_verdict::regression:
+        return "regression";
+    case benchmark_verdict::improvement:
+        return "improvement";
+    case benchmark_verdict::added:
+        return "added";
+    case benchmark_verdict::missing:
+        return "missing";
+    }
+    return "unknown";
+}
+
+struct benchmark_comparison
+{
+    std::string       name;
+    benchmark_verdict verdict = benchmark_verdict::unchanged;
+
+    double baseline_median = 0.0; // Seconds per run
+    double current_median  = 0.0;
+    double change          = 0.0; // Of the median, relative to the baseline
+    double p_value         = 1.0; // Two-sided Mann-Whitney
+};
+
+inline std::vector<benchmark_comparison>
+compare_benchmarks(std::vector<benchmark_baseline_entry> const& baseline,
+                   std::vector<benchmark_result> const&         results,
+                   benchmark_options const&                     options)
+{
+    std::vector<benchmark_comparison> ret;
+
+    auto const find_baseline = [&](std::string const& name)
+    {
+        return std::find_if(baseline.begin(), baseline.end(),
+                            [&](benchmark_baseline_entry const& e)
+                            { return e.name == name; });
+    };
+
+    for (auto const& r : results)
+    {
+        benchmark_comparison c;
+        c.name           = r.name;
+        c.current_median = r.seconds.median;
+
+        auto const base = find_baseline(r.name);
+
+        if (base == baseline.end())
+        {
+            c.verdict = benchmark_verdict::added;
+            ret.push_back(std::move(c));
+            continue;
+        }
+
+        c.baseline_median = compute_statistics(base->samples).median;
+        c.change          = c.baseline_median > 0.0
+                                ? c.current_median / c.baseline_median - 1.0
+                                : 0.0;
+
+        auto const test = mann_whitney_u_test(r.seconds.samples, base->samples);
+        c.p_value       = test.p_two_sided;
+
+        if (c.p_value < options.alpha && c.change > options.threshold)
+        {
+            c.verdict = benchmark_verdict::regression;
+        }
+        else if (c.p_value < options.alpha && c.change < -options.threshold)
+        {
+            c.verdict = benchmark_verdict::improvement;
+        }
+
+        ret.push_back(std::move(c));
+    }
+
+    std::regex const filter(options.filter);
+
+    for (auto const& e : baseline)
+    {
+        bool const ran = std::any_of(results.begin(), results.end(),
+                                     [&](benchmark_result const& r)
+                                     { return r.name == e.name; });
+
+        if (!ran && std::regex_search(e.name, filter))
+        {
+            benchmark_comparison c;
+            c.name            = e.name;
+            c.verdict         = benchmark_verdict::missing;
+            c.baseline_median = compute_statistics(e.samples).median;
+            ret.push_back(std::move(c));
+        }
+    }
+
+    return ret;
+}
+
+inline bool has_regressions(std::vector<benchmark_comparison> const& cs)
+{
+    return std::any_of(cs.begin(), cs.end(),
+                       [](benchmark_comparison const& c)
+                       { return c.verdict == benchmark_verdict::regression; });
+}
+
+inline void
+write_benchmark_comparison(std::ostream&                            os,
+                           std::vector<benchmark_comparison> const& cs,
+                           std::string const&                       format)
+{
+    char buffer[512];
+
+    if (format == "csv")
+    {
+        os << "name,baseline_median,current_median,change,p_value,verdict\n";
+        for (auto const& c : cs)
+        {
+            std::snprintf(buffer, sizeof(buffer), ",%.6e,%.6e,%.4f,%.4g,%s\n",
+                          c.baseline_median, c.current_median, c.change,
+                          c.p_value, to_string(c.verdict));
+            os << c.name << buffer;
+        }
+    }
+    else if (format == "json")
+    {
+        os << "{\n  \"comparisons\": [";
+        for (std::size_t i = 0; i < cs.size(); ++i)
+        {
+            auto const& c = cs[i];
+            std::snprintf(buffer, sizeof(buffer),
+                          ", \"baseline_median\": %.6e, "
+                          "\"current_median\": %.6e, \"change\": %.4f, "
+                          "\"p_value\": %.4g, \"verdict\": \"%s\"}",
+                          c.baseline_median, c.current_median, c.change,
+                          c.p_value, to_string(c.verdict));
+            os << (i ? "," : "") << "\n    {\"name\": "
+               << detail::json_quote(c.name) << buffer;
+        }
+        os << "\n  ]\n}\n";
+    }
+    else
+    {
+        SYSML_THROW_ASSERT(format == "text")
+            << "Unknown benchmark output format " << format;
+
+        std::size_t width = 4;
+        for (auto const& c : cs)
+        {
+            width = std::max(width, c.name.size());
+        }
+
+        std::snprintf(buffer, sizeof(buffer), "%-*s %12s %12s %9s %9s  %s\n",
+                      static_cast<int>(width), "name", "baseline", "current",
+                      "change", "p", "verdict");
+        os << buffer;
+
+        for (auto const& c : cs)
+        {
+            std::snprintf(buffer, sizeof(buffer),
+                          "%-*s %12s %12s %+8.2f%% %9.3g  %s\n",
+                          static_cast<int>(width), c.name.c_str(),
+                          detail::format_benchmark_time(c.baseline_median)
+                              .c_str(),
+                          detail::format_benchmark_time(c.current_median)
+                              .c_str(),
+                          c.change * 100.0, c.p_value, to_string(c.verdict));
+            os << buffer;
+        }
+    }
+}
+
+// Parses --filter=, --repetitions=, --seconds=, --min_iterations=,
+// --max_iterations=, --timer=, --cpu=, --format=, --list, --baseline=,
+// --alpha= and --threshold=; throws on anything else.
+inline benchmark_options parse_benchmark_options(int argc, char* argv[])
+{
+    benchmark_options ret;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const arg   = argv[i];
+        auto const        eq    = arg.find('=');
+        std::string const key   = arg.substr(0, eq);
+        std::string const value = eq == std::string::npos
+                                      ? std::string()
+                                      : arg.substr(eq + 1);
+
+        if (key == "--list")
+        {
+            ret.list = true;
+        }
+        else if (key == "--filter")
+        {
+            ret.filter = value;
+        }
+        else if (key == "--repetitions")
+        {
+            ret.repetitions = static_cast<unsigned>(std::stoul(value));
+        }
+        else if (key == "--seconds")
+        {
+            ret.seconds = std::stod(value);
+        }
+        else if (key == "--min_iterations")
+        {
+            ret.min_iterations = std::stoull(value);
+        }
+        else if (key == "--max_iterations")
+        {
+            ret.max_iterations = std::stoull(value);
+        }
+        else if (key == "--timer")
+        {
+            SYSML_THROW_ASSERT(value == "steady" || value == "tsc" ||
+                               value == "precise")
+                << "Unknown benchmark timer " << value;
+#if defined(SYSML_ON_ARCH_AMD64)
+            SYSML_THROW_ASSERT(value != "tsc" || tsc_timer::supported())
+#else
+            SYSML_THROW_ASSERT(value != "tsc")
+#endif
+                << "The tsc timer is not supported on this cpu";
+            ret.timer = value;
+        }
+        else if (key == "--cpu")
+        {
+            ret.cpu = std::stoi(value);
+        }
+        else if (key == "--format")
+        {
+            SYSML_THROW_ASSERT(value == "text" || value == "csv" ||
+                               value == "json")
+                << "Unknown benchmark output format " << value;
+            ret.format = value;
+        }
+        else if (key == "--baseline")
+        {
+            ret.baseline = value;
+        }
+        else if (key == "--alpha")
+        {
+            ret.alpha = std::stod(value);
+        }
+        else if (key == "--threshold")
+        {
+            ret.threshold = std::stod(value);
+        }
+        else
+        {
+            SYSML_THROW_ASSERT(false) << "Unknown argument " << arg;
+        }
+    }
+
+    return ret;
+}
+
+// Returns 1 on errors, and 2 when comparing with a baseline and some
+// benchmark regressed.
+inline int benchmark_main(int argc, char* argv[])
+{
+    try
+    {
+        auto const options = parse_benchmark_options(argc, argv);
+
+        if (options.list)
+        {
+            for (auto const& b : selected_benchmarks(options))
+            {
+                std::cout << b.name << "\n";
+            }
+            return 0;
+        }
+
+        if (!options.baseline.empty())
+        {
+            auto const baseline = read_benchmark_baseline(options.baseline);
+            auto const comparison =
+                compare_benchmarks(baseline, run_benchmarks(options), options);
+
+            write_benchmark_comparison(std::cout, comparison, options.format);
+
+            return has_regressions(comparison) ? 2 : 0;
+        }
+
+        write_benchmark_results(std::cout, run_benchmarks(options),
+                                options.format);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << "\n"
+                  << "Usage: " << argv[0]
+                  << " [--filter=REGEX] [--repetitions=N] [--seconds=S]"
+                     " [--min_iterations=N] [--max_iterations=N]"
+                     " [--timer=steady|tsc|precise] [--cpu=N]"
+                     " [--format=text|csv|json] [--list]"
+                     " [--baseline=FILE [--alpha=P] [--threshold=R]]\n";
+        return 1;
+    }
+
+    return 0;
+}
+
+} // namespace sysml
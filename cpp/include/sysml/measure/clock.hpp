@@ -0,0 +1,232 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/predef.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#if defined(SYSML_ON_ARCH_AMD64)
+#    include <cpuid.h>
+#endif
+
+namespace sysml
+{
+
+// Timers used by the measure functions.  A timer is a class with
+//
+//   static std::uint64_t start() noexcept;  // read before the timed code
+//   static std::uint64_t stop() noexcept;   // read after it
+//   static double seconds(std::uint64_t ticks);
+//
+// start() and stop() may differ in how they order the read with the
+// surrounding instructions.
+
+// std::chrono::steady_clock, in nanoseconds.
+struct steady_timer
+{
+    static std::uint64_t start() noexcept { return now(); }
+    static std::uint64_t stop() noexcept { return now(); }
+
+    static double seconds(std::uint64_t ticks)
+    {
+        return static_cast<double>(ticks) / 1e9;
+    }
+
+private:
+    static std::uint64_t now() noexcept
+    {
+        using namespace std::chrono;
+        return static_cast<std::uint64_t>(
+            duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+                .count());
+    }
+};
+
+#if defined(SYSML_ON_ARCH_AMD64)
+
+// The time stamp counter, read with the code being timed fenced in:
+// lfence; rdtsc; lfence before it and rdtscp; lfence after it.  Only
+// meaningful when supported(), i.e. the cpu has rdtscp and an
+// invariant tsc (constant rate, running in all C-states); its
+// frequency is calibrated against steady_clock on first use.
+struct tsc_timer
+{
+    static std::uint64_t start() noexcept
+    {
+        std::uint32_t lo, hi;
+        asm volatile("lfence\n\t"
+                     "rdtsc\n\t"
+                     "lfence"
+                     : "=a"(lo), "=d"(hi)
+                     :
+                     : "memory");
+        return lo | (static_cast<std::uint64_t>(hi) << 32);
+    }
+
+    static std::uint64_t stop() noexcept
+    {
+        std::uint32_t lo, hi;
+        asm volatile("rdtscp\n\t"
+                     "lfence"
+                     : "=a"(lo), "=d"(hi)
+                     :
+                     : "rcx", "memory");
+        return lo | (static_cast<std::uint64_t>(hi) << 32);
+    }
+
+    static double seconds(std::uint64_t ticks)
+    {
+        return static_cast<double>(ticks) / frequency();
+    }
+
+    static bool supported() noexcept
+    {
+        static bool const ret = []
+        {
+            unsigned eax, ebx, ecx, edx;
+
+            if (!__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) ||
+                !(edx & (1u << 27))) // rdtscp
+            {
+                return false;
+            }
+
+            return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) &&
+                   (edx & (1u << 8)); // Invariant tsc
+        }();
+
+        return ret;
+    }
+
+    // Ticks per second.
+    static double frequency()
+    {
+        static double const ret = calibrate();
+        return ret;
+    }
+
+private:
+    // Counts the ticks over about 20ms of steady_clock, taking the
+    // shortest of a few tries at reading both clocks together.
+    static double calibrate()
+    {
+        using namespace std::chrono;
+
+        struct reading
+        {
+            std::uint64_t            tsc;
+            steady_clock::time_point time;
+        };
+
+        auto const read_both = []
+        {
+            reading ret{};
+            auto    best = ~std::uint64_t(0);
+
+            for (int i = 0; i < 8; ++i)
+            {
+                auto before = start();
+                auto time   = steady_clock::now();
+                auto after  = stop();
+
+                if (after - before < best)
+                {
+                    best = after - before;
+                    ret  = {before + (after - before) / 2, time};
+                }
+            }
+
+            return ret;
+        };
+
+        auto const first = read_both();
+
+        while (steady_clock::now() - first.time < milliseconds(20))
+        {
+        }
+
+        auto const last = read_both();
+
+        return static_cast<double>(last.tsc - first.tsc) /
+               duration<double>(last.time - first.time).count();
+    }
+};
+
+#endif
+
+// tsc_timer where supported, steady_timer otherwise.
+struct precise_timer
+{
+    static std::uint64_t start() noexcept
+    {
+#if defined(SYSML_ON_ARCH_AMD64)
+        if (use_tsc())
+        {
+            return tsc_timer::start();
+        }
+#endif
+        return steady_timer::start();
+    }
+
+    static std::uint64_t stop() noexcept
+    {
+#if defined(SYSML_ON_ARCH_AMD64)
+        if (use_tsc())
+        {
+            return tsc_timer::stop();
+        }
+#endif
+        return steady_timer::stop();
+    }
+
+    static double seconds(std::uint64_t ticks)
+    {
+#if defined(SYSML_ON_ARCH_AMD64)
+        if (use_tsc())
+        {
+            return tsc_timer::seconds(ticks);
+        }
+#endif
+        return steady_timer::seconds(ticks);
+    }
+
+    static bool use_tsc() noexcept
+    {
+#if defined(SYSML_ON_ARCH_AMD64)
+        return tsc_timer::supported();
+#else
+        return false;
+#endif
+    }
+};
+
+// The cost of reading the timer around nothing, in seconds: the
+// shortest of many back to back start() and stop() pairs.  Measured
+// once per timer.
+template <class Timer>
+double timer_overhead_seconds()
+{
+    static double const ret = []
+    {
+        auto best = ~std::uint64_t(0);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto start = Timer::start();
+            auto end   = Timer::stop();
+            best       = std::min<std::uint64_t>(best, end - start);
+        }
+
+        return Timer::seconds(best);
+    }();
+
+    return ret;
+}
+
+} // namespace sysml
@@ -5,7 +5,12 @@
 
 #pragma once
 
+#include "sysml/measure/clock.hpp"
+#include "sysml/measure/perf_counters.hpp"
+#include "sysml/measure/statistics.hpp"
+
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <chrono>
 #include <cstdint>
@@ -31,16 +36,31 @@ __attribute__((always_inline)) inline auto measure_single_run(Fn&& fn)
     return end - start;
 }
 
-template <class Fn>
+// Time of a single run of fn in seconds, less the overhead of reading
+// the timer.
+template <class Timer = steady_timer, class Fn>
 __attribute__((always_inline)) inline double measure_single_run_seconds(Fn&& fn)
 {
-    using namespace std::chrono;
+    double const overhead = timer_overhead_seconds<Timer>();
 
-    auto time = measure_single_run<high_resolution_clock>(std::forward<Fn>(fn));
+    auto start = Timer::start();
+    fn();
+    auto end = Timer::stop();
 
-    auto nsecs = duration_cast<nanoseconds>(time).count();
+    return std::max(0.0, Timer::seconds(end - start) - overhead);
+}
 
-    return static_cast<double>(nsecs) / 1e9;
+// As above, also returning the counts of the group during the run.
+template <class Timer = steady_timer, class Fn>
+__attribute__((always_inline)) inline double
+measure_single_run_seconds(Fn&& fn, perf_counter_group& counters,
+                           perf_counts& counts)
+{
+    counters.start();
+    double ret = measure_single_run_seconds<Timer>(std::forward<Fn>(fn));
+    counts     = counters.stop();
+
+    return ret;
 }
 
 template <class Fn>
@@ -53,7 +73,8 @@ __attribute__((always_inline)) inline void warmup_run(Fn&&     fn,
     }
 }
 
-template <class Fn>
+// Runs fn iterations times, or until seconds (timed with Timer) ran out.
+template <class Timer = steady_timer, class Fn>
 __attribute__((always_inline)) inline void
 warmup_run_time_limited(Fn&& fn, unsigned iterations = 0, double seconds = 1.0)
 {
@@ -61,7 +82,7 @@ warmup_run_time_limited(Fn&& fn, unsigned iterations = 0, double seconds = 1.0)
 
     for (unsigned i = 0; i < iterations && total_time <= seconds; ++i)
     {
-        total_time += measure_single_run_seconds(fn);
+        total_time += measure_single_run_seconds<Timer>(fn);
     }
 }
 
@@ -81,20 +102,139 @@ struct flops_measurement
     double median   = std::numeric_limits<double>::max();
 };
 
-template <class Fn>
+// The shortest, mean and median times of the statistics.
+inline time_duraton_measurement
+as_time_duration(measurement_statistics const& stats)
+{
+    return {stats.min, stats.mean, stats.median};
+}
+
+// Floating point operations per second, for flop_count operations per
+// run; shortest is the rate of the fastest run.
+inline flops_measurement as_flops(measurement_statistics const& stats,
+                                  double                        flop_count)
+{
+    auto rate = [&](double seconds)
+    { return seconds > 0.0 ? flop_count / seconds : 0.0; };
+
+    return {rate(stats.min), rate(stats.mean), rate(stats.median)};
+}
+
+// Times iterations runs of fn (in seconds) after warmup_iterations
+// untimed ones, and summarizes them.
+template <class Timer = steady_timer, class Fn>
+measurement_statistics
+measure_statistics(Fn&& fn, unsigned iterations = 1,
+                   unsigned                  warmup_iterations = 1,
+                   statistics_options const& options           = {})
+{
+    detail::warmup_run(fn, warmup_iterations);
+
+    std::vector<double> measurements(iterations);
+
+    for (auto& m : measurements)
+    {
+        m = detail::measure_single_run_seconds<Timer>(fn);
+    }
+
+    return compute_statistics(std::move(measurements), options);
+}
+
+// Wall clock time and hardware counter statistics of the same runs.
+struct counted_measurement
+{
+    measurement_statistics seconds;
+
+    // Indexed by perf_counter; the ones with a count of zero weren't
+    // available.
+    std::array<measurement_statistics, num_perf_counters> counters;
+
+    measurement_statistics const& operator[](perf_counter c) const
+    {
+        return counters[static_cast<std::size_t>(c)];
+    }
+
+    bool has(perf_counter c) const { return (*this)[c].count > 0; }
+
+    // Instructions per cycle, of the medians; 0 when not available.
+    double ipc() const
+    {
+        auto const& cycles = (*this)[perf_counter::cycles];
+        auto const& instrs = (*this)[perf_counter::instructions];
+
+        return has(perf_counter::cycles) && has(perf_counter::instructions) &&
+                       cycles.median > 0.0
+                   ? instrs.median / cycles.median
+                   : 0.0;
+    }
+};
+
+// Times iterations runs of fn after warmup_iterations untimed ones,
+// reading the counters of the group around every timed run.  Only the
+// calling thread is counted; work fn hands off to other threads (e.g.
+// the workers of a cpu_pool) isn't.
+template <class Timer = steady_timer, class Fn>
+counted_measurement
+measure_counted(Fn&& fn, perf_counter_group& group, unsigned iterations = 1,
+                unsigned                  warmup_iterations = 1,
+                statistics_options const& options           = {})
+{
+    detail::warmup_run(fn, warmup_iterations);
+
+    std::vector<double>                                seconds(iterations);
+    std::array<std::vector<double>, num_perf_counters> counts;
+
+    for (auto& s : seconds)
+    {
+        perf_counts run;
+        s = detail::measure_single_run_seconds<Timer>(fn, group, run);
+
+        for (std::size_t c = 0; c < num_perf_counters; ++c)
+        {
+            if (run.values[c])
+            {
+                counts[c].push_back(*run.values[c]);
+            }
+        }
+    }
+
+    counted_measurement ret;
+
+    ret.seconds = compute_statistics(std::move(seconds), options);
+
+    for (std::size_t c = 0; c < num_perf_counters; ++c)
+    {
+        ret.counters[c] = compute_statistics(std::move(counts[c]), options);
+    }
+
+    return ret;
+}
+
+// As above, with a group of all the counters.
+template <class Timer = steady_timer, class Fn>
+counted_measurement measure_counted(Fn&& fn, unsigned iterations = 1,
+                                    unsigned warmup_iterations = 1,
+                                    statistics_options const& options = {})
+{
+    perf_counter_group group;
+    return measure_counted<Timer>(std::forward<Fn>(fn), group, iterations,
+                                  warmup_iterations, options);
+}
+
+template <class Timer = steady_timer, class Fn>
 double measure_fastest(Fn&& fn, unsigned iterations = 1)
 {
     double ret = std::numeric_limits<double>::max();
 
     for (unsigned i = 0; i < iterations; ++i)
     {
-        ret = std::min(ret, detail::measure_single_run_seconds(fn));
+        ret = std::min(ret, detail::measure_single_run_seconds<Timer>(fn));
     }
 
     return ret;
 }
 
-template <class Fn>
+template <class Timer = steady_timer, class Fn>
 double measure_fastest_time_limited(Fn&& fn, unsigned iterations = 1,
                                     double seconds = 1.0)
 {
@@ -103,7 +243,7 @@ double measure_fastest_time_limited(Fn&& fn, unsigned iterations = 1,
 
     for (unsigned i = 0; i < iterations && total_time <= seconds; ++i)
     {
-        auto t = detail::measure_single_run_seconds(fn);
+        auto t = detail::measure_single_run_seconds<Timer>(fn);
         ret    = std::min(ret, t);
         total_time += t;
     }
@@ -111,7 +251,8 @@ double measure_fastest_time_limited(Fn&& fn, unsigned iterations = 1,
     return ret;
 }
 
-template <class Fn>
+// The loop of iterations runs is timed as a whole.
+template <class Timer = steady_timer, class Fn>
 double measure_mean(Fn&& fn, unsigned iterations = 1,
                     unsigned warmup_iterations = 1)
 {
@@ -122,22 +263,19 @@ double measure_mean(Fn&& fn, unsigned iterations = 1,
 
     detail::warmup_run(fn, warmup_iterations);
 
-    using namespace std::chrono;
-
-    auto start = high_resolution_clock::now();
+    auto start = Timer::start();
 
-    for (int i = 0; i < iterations; ++i)
+    for (unsigned i = 0; i < iterations; ++i)
     {
         fn();
     }
 
-    auto end   = high_resolution_clock::now();
-    auto nsecs = duration_cast<nanoseconds>(end - start).count();
+    auto end = Timer::stop();
 
-    return static_cast<double>(nsecs) / 1e9 / iterations;
+    return Timer::seconds(end - start) / iterations;
 }
 
-template <class Fn>
+template <class Timer = steady_timer, class Fn>
 double measure_mean_time_limited(Fn&& fn, unsigned iterations = 1,
                                  unsigned warmup_iterations = 1,
                                  double   seconds           = 1.0)
@@ -149,7 +287,7 @@ double measure_mean_time_limited(Fn&& fn, unsigned iterations = 1,
         return ret;
     }
 
-    detail::warmup_run_time_limited(fn, warmup_iterations, seconds);
+    detail::warmup_run_time_limited<Timer>(fn, warmup_iterations, seconds);
 
     double   total_time     = 0.0;
     unsigned iterations_run = 0;
@@ -157,19 +295,17 @@ double measure_mean_time_limited(Fn&& fn, unsigned iterations = 1,
     for (; iterations_run < iterations && total_time <= seconds;
          ++iterations_run)
     {
-        total_time += detail::measure_single_run_seconds(fn);
+        total_time += detail::measure_single_run_seconds<Timer>(fn);
     }
 
     return total_time / iterations_run;
 }
 
-template <class Fn>
+template <class Timer = steady_timer, class Fn>
 double measure_mean_timed(Fn&& fn, double seconds = 1.0)
 {
-    using namespace std::chrono;
-
     std::size_t n_iter = 1;
-    auto        start  = high_resolution_clock::now();
+    auto        start  = Timer::start();
 
     while (1)
     {
@@ -178,9 +314,8 @@ double measure_mean_timed(Fn&& fn, double seconds = 1.0)
             fn();
         }
 
-        auto end   = high_resolution_clock::now();
-        auto nsecs = duration_cast<nanoseconds>(end - start).count();
-        if (static_cast<double>(nsecs) / 1e9 > seconds / 2)
+        auto end = Timer::stop();
+        if (Timer::seconds(end - start) > seconds / 2)
         {
             break;
         }
@@ -188,18 +323,16 @@ double measure_mean_timed(Fn&& fn, double seconds = 1.0)
         n_iter *= 2;
     }
 
-    return measure_mean(fn, n_iter * 2);
+    return measure_mean<Timer>(fn, n_iter * 2);
 }
 
-template <class Fn>
+template <class Timer = steady_timer, class Fn>
 double measure_mean_timed_and_bounded(
     Fn&& fn, double seconds = 1.0, std::size_t min_iterations = 1,
     std::size_t max_iterations = std::numeric_limits<std::size_t>::max())
 {
-    using namespace std::chrono;
-
     std::size_t n_iter = 1;
-    auto        start  = high_resolution_clock::now();
+    auto        start  = Timer::start();
 
     while (1)
     {
@@ -208,9 +341,8 @@ double measure_mean_timed_and_bounded(
             fn();
         }
 
-        auto end   = high_resolution_clock::now();
-        auto nsecs = duration_cast<nanoseconds>(end - start).count();
-        if (static_cast<double>(nsecs) / 1e9 > seconds / 2)
+        auto end = Timer::stop();
+        if (Timer::seconds(end - start) > seconds / 2)
         {
             break;
         }
@@ -221,10 +353,10 @@ double measure_mean_timed_and_bounded(
     n_iter = std::max(min_iterations, n_iter);
     n_iter = std::min(max_iterations, n_iter);
 
-    return measure_mean(fn, n_iter * 2);
+    return measure_mean<Timer>(fn, n_iter * 2);
 }
 
-template <class Fn>
+template <class Timer = steady_timer, class Fn>
 double measure_median(Fn&& fn, unsigned iterations = 1,
                       unsigned warmup_iterations = 1)
 {
@@ -241,7 +373,7 @@ double measure_median(Fn&& fn, unsigned iterations = 1,
 
     for (int i = 0; i < iterations; ++i)
     {
-        measurements[i] = detail::measure_single_run_seconds(fn);
+        measurements[i] = detail::measure_single_run_seconds<Timer>(fn);
     }
 
     std::sort(std::begin(measurements), std::end(measurements));
@@ -249,7 +381,7 @@ double measure_median(Fn&& fn, unsigned iterations = 1,
     return measurements[iterations / 2];
 }
 
-template <class Fn>
+template <class Timer = steady_timer, class Fn>
 double measure_median_time_limited(Fn&& fn, unsigned iterations = 1,
                                    unsigned warmup_iterations = 1,
                                    double   seconds           = 1.0)
@@ -259,7 +391,7 @@ double measure_median_time_limited(Fn&& fn, unsigned iterations = 1,
         return std::numeric_limits<double>::max();
     }
 
-    detail::warmup_run_time_limited(fn, warmup_iterations, seconds);
+    detail::warmup_run_time_limited<Timer>(fn, warmup_iterations, seconds);
 
     std::vector<double> measurements(iterations);
 
@@ -269,7 +401,7 @@ double measure_median_time_limited(Fn&& fn, unsigned iterations = 1,
 
     for (; ran < iterations && total_time <= seconds; ++ran)
     {
-        measurements[ran] = detail::measure_single_run_seconds(fn);
+        measurements[ran] = detail::measure_single_run_seconds<Timer>(fn);
     }
 
     std::sort(std::begin(measurements), std::end(measurements));
@@ -277,21 +409,17 @@ double measure_median_time_limited(Fn&& fn, unsigned iterations = 1,
     return measurements[ran / 2];
 }
 
-template <class Fn>
+template <class Timer = steady_timer, class Fn>
 std::tuple<double, double, double> measure_all(Fn&& fn, int iterations = 1,
                                                int warmup_iterations = 1)
 {
-    using namespace std::chrono;
-
-    auto fastest = nanoseconds::max().count();
-
-    std::vector<double> measurements(iterations);
-
     if (iterations <= 0)
     {
         return {-1., -1., -1.};
     }
 
+    std::vector<double> measurements(iterations);
+
     for (int i = 0; i < warmup_iterations; ++i)
     {
         fn();
@@ -299,13 +427,7 @@ std::tuple<double, double, double> measure_all(Fn&& fn, int iterations = 1,
 
     for (int i = 0; i < iterations; ++i)
     {
-        auto start = high_resolution_clock::now();
-        fn();
-        auto end        = high_resolution_clock::now();
-        auto nsecs      = duration_cast<nanoseconds>(end - start).count();
-        measurements[i] = static_cast<double>(nsecs) / 1e9;
-
-        fastest = std::min(fastest, nsecs);
+        measurements[i] = detail::measure_single_run_seconds<Timer>(fn);
     }
 
     std::sort(std::begin(measurements), std::end(measurements));
@@ -314,7 +436,7 @@ std::tuple<double, double, double> measure_all(Fn&& fn, int iterations = 1,
     double the_mean =
         std::accumulate(std::begin(measurements), std::end(measurements), 0.0) /
         measurements.size();
-    double the_fastest = static_cast<double>(fastest) / 1e9;
+    double the_fastest = measurements.front();
 
     return {the_fastest, the_mean, the_median};
 }
@@ -0,0 +1,357 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#    include <cerrno>
+#    include <cstring>
+#    include <linux/perf_event.h>
+#    include <sys/ioctl.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+namespace sysml
+{
+
+enum class perf_counter : unsigned
+{
+    cycles,
+    instructions,
+    l1d_misses,    // L1 data cache read misses
+    llc_misses,    // Last level cache misses
+    branch_misses, // Mispredicted branches
+    dtlb_misses    // Data TLB read misses
+};
+
+inline constexpr std::size_t num_perf_counters = 6;
+
+inline char const* to_string(perf_counter c) noexcept
+{
+    switch (c)
+    {
+    case perf_counter::cycles:
+        return "cycles";
+    case perf_counter::instructions:
+        return "instructions";
+    case perf_counter::l1d_misses:
+        return "l1d_misses";
+    case perf_counter::llc_misses:
+        return "llc_misses";
+    case perf_counter::branch_misses:
+        return "branch_misses";
+    case perf_counter::dtlb_misses:
+        return "dtlb_misses";
+    }
+    return "unknown";
+}
+
+inline std::vector<perf_counter> all_perf_counters()
+{
+    return {perf_counter::cycles,        perf_counter::instructions,
+            perf_counter::l1d_misses,    perf_counter::llc_misses,
+            perf_counter::branch_misses, perf_counter::dtlb_misses};
+}
+
+// Counts of a single run; empty for the counters that couldn't be
+// opened or weren't scheduled on the hardware during the run.
+struct perf_counts
+{
+    std::array<std::optional<double>, num_perf_counters> values;
+
+    std::optional<double> operator[](perf_counter c) const
+    {
+        return values[static_cast<std::size_t>(c)];
+    }
+};
+
+// A group of hardware counters of the calling thread, read together
+// through perf_event_open.  Only user space is counted, so the default
+// perf_event_paranoid level of 2 suffices.  Counters that can't be
+// opened (not permitted, not supported by the cpu or hypervisor) are
+// left out; when none can, available() is false, error() tells why,
+// and stop() returns empty counts.
+//
+// The kernel only schedules a group as a whole, so a group needing
+// more counters than the cpu offers (common in VMs) opens fine but
+// never counts.  The constructor tries the group out, and leaves out
+// the last counters until it gets scheduled; error() names them.
+//
+// When the group doesn't fit in the hardware counters the kernel
+// multiplexes it, and the counts are scaled by the fraction of the run
+// the group was scheduled for.
+class perf_counter_group
+{
+private:
+    std::vector<perf_counter> members_; // In the order read() returns them
+    std::vector<int>          fds_;     // fds_[0] is the group leader
+    std::string               error_;
+
+#if defined(__linux__)
+    static perf_event_attr attributes(perf_counter c)
+    {
+        perf_event_attr attr{};
+
+        attr.size = sizeof(attr);
+
+        auto const cache_read_miss = [](std::uint64_t cache)
+        {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+
+        switch (c)
+        {
+        case perf_counter::cycles:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case perf_counter::instructions:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case perf_counter::l1d_misses:
+            attr.type   = PERF_TYPE_HW_CACHE;
+            attr.config = cache_read_miss(PERF_COUNT_HW_CACHE_L1D);
+            break;
+        case perf_counter::llc_misses:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case perf_counter::branch_misses:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case perf_counter::dtlb_misses:
+            attr.type   = PERF_TYPE_HW_CACHE;
+            attr.config = cache_read_miss(PERF_COUNT_HW_CACHE_DTLB);
+            break;
+        }
+
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_GROUP |
+                              PERF_FORMAT_TOTAL_TIME_ENABLED |
+                              PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return attr;
+    }
+
+    static std::string paranoid_level()
+    {
+        std::ifstream in("/proc/sys/kernel/perf_event_paranoid");
+        std::string   ret;
+        if (!(in >> ret))
+        {
+            ret = "unknown";
+        }
+        return ret;
+    }
+
+    void open(std::vector<perf_counter> const& counters)
+    {
+        for (auto c : counters)
+        {
+            // Duplicates would read into the same slot; keeping every
+            // counter once also bounds the group to num_perf_counters.
+            if (has(c))
+            {
+                continue;
+            }
+
+            auto attr = attributes(c);
+
+            // The leader starts disabled; the members follow it.
+            attr.disabled = fds_.empty() ? 1 : 0;
+
+            int const leader = fds_.empty() ? -1 : fds_.front();
+            int const fd     = static_cast<int>(
+                syscall(SYS_perf_event_open, &attr, 0, -1, leader,
+                        PERF_FLAG_FD_CLOEXEC));
+
+            if (fd < 0)
+            {
+                int const err = errno;
+
+                if (error_.empty())
+                {
+                    error_ = std::string("Can't open the ") + to_string(c) +
+                             " counter: " + std::strerror(err);
+                    if (err == EACCES || err == EPERM)
+                    {
+                        error_ += " (perf_event_paranoid is " +
+                                  paranoid_level() + ")";
+                    }
+                }
+                continue;
+            }
+
+            fds_.push_back(fd);
+            members_.push_back(c);
+        }
+    }
+
+    // nr, time_enabled, time_running, then a value per member.
+    using read_buffer = std::array<std::uint64_t, 3 + num_perf_counters>;
+
+    bool read_group(read_buffer& buffer) noexcept
+    {
+        auto const bytes = (3 + fds_.size()) * sizeof(std::uint64_t);
+
+        return ::read(fds_.front(), buffer.data(), bytes) ==
+                   static_cast<ssize_t>(bytes) &&
+               buffer[0] == fds_.size();
+    }
+
+    // Whether the group was scheduled on the hardware while counting a
+    // bit of work.
+    bool scheduled() noexcept
+    {
+        start();
+
+        std::uint64_t volatile sink = 0;
+        for (std::uint64_t i = 0; i < 10000; ++i)
+        {
+            sink = sink + i;
+        }
+
+        ioctl(fds_.front(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        read_buffer buffer{};
+        return read_group(buffer) && buffer[2] != 0;
+    }
+
+    void shrink_to_schedulable()
+    {
+        std::string left_out;
+
+        while (available() && !scheduled())
+        {
+            close(fds_.back());
+            fds_.pop_back();
+
+            left_out = to_string(members_.back()) +
+                       (left_out.empty() ? "" : ", " + left_out);
+            members_.pop_back();
+        }
+
+        if (!left_out.empty())
+        {
+            if (!error_.empty())
+            {
+                error_ += "; ";
+            }
+            error_ += "Can't schedule all the counters together, left out " +
+                      left_out;
+        }
+    }
+#endif
+
+public:
+    // Duplicates in counters are ignored.
+    explicit perf_counter_group(
+        std::vector<perf_counter> const& counters = all_perf_counters())
+    {
+#if defined(__linux__)
+        open(counters);
+        shrink_to_schedulable();
+#else
+        (void)counters;
+        error_ = "Hardware counters are only supported on Linux";
+#endif
+    }
+
+    ~perf_counter_group()
+    {
+#if defined(__linux__)
+        for (auto it = fds_.rbegin(); it != fds_.rend(); ++it)
+        {
+            close(*it);
+        }
+#endif
+    }
+
+    perf_counter_group(perf_counter_group const&)            = delete;
+    perf_counter_group& operator=(perf_counter_group const&) = delete;
+
+    // Whether at least one of the counters could be opened.
+    bool available() const noexcept { return !fds_.empty(); }
+
+    bool has(perf_counter c) const noexcept
+    {
+        for (auto m : members_)
+        {
+            if (m == c)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<perf_counter> const& counters() const noexcept
+    {
+        return members_;
+    }
+
+    // Why some or all of the counters are missing; empty when none is.
+    std::string const& error() const noexcept { return error_; }
+
+    // Zeroes and starts all the counters of the group.
+    void start() noexcept
+    {
+#if defined(__linux__)
+        if (available())
+        {
+            ioctl(fds_.front(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds_.front(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    // Stops the counters and returns their counts since start().
+    perf_counts stop() noexcept
+    {
+        perf_counts ret;
+
+#if defined(__linux__)
+        if (!available())
+        {
+            return ret;
+        }
+
+        ioctl(fds_.front(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        read_buffer buffer{};
+
+        if (!read_group(buffer) || buffer[2] == 0)
+        {
+            return ret;
+        }
+
+        double const scale = static_cast<double>(buffer[1]) /
+                             static_cast<double>(buffer[2]);
+
+        for (std::size_t i = 0; i < members_.size(); ++i)
+        {
+            ret.values[static_cast<std::size_t>(members_[i])] =
+                static_cast<double>(buffer[3 + i]) * scale;
+        }
+#endif
+
+        return ret;
+    }
+};
+
+} // namespace sysml
@@ -0,0 +1,238 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace sysml
+{
+
+struct statistics_options
+{
+    // Keep the (sorted) samples in the result.
+    bool keep_samples = false;
+
+    // Reject the samples farther from the median than mad_threshold
+    // times the scaled median absolute deviation (1.4826 * MAD, which
+    // estimates the standard deviation for normal data).  3.5 is a
+    // common choice; 0 keeps everything.  Nothing is rejected when
+    // more than half of the samples are equal (MAD of zero).
+    double mad_threshold = 0.0;
+};
+
+struct measurement_statistics
+{
+    std::size_t count    = 0; // Samples the statistics are computed on
+    std::size_t rejected = 0; // Outliers left out
+
+    double min    = 0.0;
+    double max    = 0.0;
+    double mean   = 0.0;
+    double median = 0.0;
+    double stddev = 0.0; // Sample standard deviation
+    double p90    = 0.0;
+    double p99    = 0.0;
+    double p999   = 0.0;
+    double cv     = 0.0; // Coefficient of variation, stddev / mean
+
+    // Sorted; only with statistics_options::keep_samples.
+    std::vector<double> samples;
+};
+
+namespace detail
+{
+
+// Linear interpolation between the closest ranks of sorted samples.
+inline double sorted_percentile(std::vector<double> const& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    double const rank  = p / 100.0 * static_cast<double>(sorted.size() - 1);
+    auto const   lower = static_cast<std::size_t>(std::floor(rank));
+    auto const   upper = std::min(lower + 1, sorted.size() - 1);
+    double const frac  = rank - static_cast<double>(lower);
+
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * frac;
+}
+
+} // namespace detail
+
+inline measurement_statistics
+compute_statistics(std::vector<double>       samples,
+                   statistics_options const& options = {})
+{
+    measurement_statistics ret;
+
+    if (samples.empty())
+    {
+        return ret;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    if (options.mad_threshold > 0.0)
+    {
+        double const median = detail::sorted_percentile(samples, 50.0);
+
+        std::vector<double> deviations(samples.size());
+        std::transform(samples.begin(), samples.end(), deviations.begin(),
+                       [&](double x) { return std::abs(x - median); });
+        std::sort(deviations.begin(), deviations.end());
+
+        double const limit = options.mad_threshold * 1.4826 *
+                             detail::sorted_percentile(deviations, 50.0);
+
+        if (limit > 0.0)
+        {
+            auto const size    = samples.size();
+            auto const outlier = [&](double x)
+            { return std::abs(x - median) > limit; };
+
+            samples.erase(
+                std::remove_if(samples.begin(), samples.end(), outlier),
+                samples.end());
+            ret.rejected = size - samples.size();
+        }
+    }
+
+    auto const n = static_cast<double>(samples.size());
+
+    ret.count  = samples.size();
+    ret.min    = samples.front();
+    ret.max    = samples.back();
+    ret.mean   = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+    ret.median = detail::sorted_percentile(samples, 50.0);
+    ret.p90    = detail::sorted_percentile(samples, 90.0);
+    ret.p99    = detail::sorted_percentile(samples, 99.0);
+    ret.p999   = detail::sorted_percentile(samples, 99.9);
+
+    if (samples.size() > 1)
+    {
+        double sum_sq = 0.0;
+        for (auto x : samples)
+        {
+            sum_sq += (x - ret.mean) * (x - ret.mean);
+        }
+        ret.stddev = std::sqrt(sum_sq / (n - 1.0));
+    }
+
+    ret.cv = ret.mean != 0.0 ? ret.stddev / ret.mean : 0.0;
+
+    if (options.keep_samples)
+    {
+        ret.samples = std::move(samples);
+    }
+
+    return ret;
+}
+
+struct rank_test_result
+{
+    // Pairs (x from a, y from b) with x > y, ties counting half.
+    double u = 0.0;
+
+    // One-sided p-values of a tending to be larger (smaller) than b,
+    // and the two-sided one.
+    double p_greater   = 1.0;
+    double p_less      = 1.0;
+    double p_two_sided = 1.0;
+};
+
+// Mann-Whitney U test of samples a and b, with the normal
+// approximation (tie and continuity corrected).  It compares the
+// distributions rather than the means, so a few outliers in either
+// sample don't decide the outcome.  The approximation is rough for
+// fewer than about 8 samples a side; with no overlap at all, 5 a side
+// still give p-values below 0.01.
+inline rank_test_result mann_whitney_u_test(std::vector<double> const& a,
+                                            std::vector<double> const& b)
+{
+    rank_test_result ret;
+
+    if (a.empty() || b.empty())
+    {
+        return ret;
+    }
+
+    // Sample values tagged with whether they come from a.
+    std::vector<std::pair<double, bool>> all;
+    all.reserve(a.size() + b.size());
+
+    for (auto x : a)
+    {
+        all.emplace_back(x, true);
+    }
+
+    for (auto x : b)
+    {
+        all.emplace_back(x, false);
+    }
+
+    std::sort(all.begin(), all.end());
+
+    // Ranks start at 1, ties get the average of their ranks.
+    double rank_sum_a = 0.0;
+    double ties       = 0.0; // Sum of t^3 - t over the groups of ties
+
+    for (std::size_t i = 0; i < all.size();)
+    {
+        std::size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first)
+        {
+            ++j;
+        }
+
+        double const rank = static_cast<double>(i + j + 1) / 2.0;
+        for (std::size_t k = i; k < j; ++k)
+        {
+            if (all[k].second)
+            {
+                rank_sum_a += rank;
+            }
+        }
+
+        double const t = static_cast<double>(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    double const n1 = static_cast<double>(a.size());
+    double const n2 = static_cast<double>(b.size());
+    double const n  = n1 + n2;
+
+    ret.u = rank_sum_a - n1 * (n1 + 1.0) / 2.0;
+
+    double const mean     = n1 * n2 / 2.0;
+    double const variance = n1 * n2 / 12.0 *
+                            ((n + 1.0) - ties / (n * (n - 1.0)));
+
+    if (variance <= 0.0)
+    {
+        return ret;
+    }
+
+    double const sd = std::sqrt(variance);
+
+    // P(Z >= z)
+    auto const upper_tail = [](double z)
+    { return 0.5 * std::erfc(z / std::sqrt(2.0)); };
+
+    ret.p_greater   = std::min(1.0, upper_tail((ret.u - mean - 0.5) / sd));
+    ret.p_less      = std::min(1.0, upper_tail((mean - ret.u - 0.5) / sd));
+    ret.p_two_sided = std::min(1.0, 2.0 * std::min(ret.p_greater, ret.p_less));
+
+    return ret;
+}
+
+} // namespace sysml
@@ -36,7 +36,7 @@ private:
             dims.begin(), dims.end(), size_type(1), std::multiplies<>{});
 
         return static_cast<Tp*>(checked_aligned_allocate(
-            default_alignment, total_elements, default_padding));
+            default_alignment, total_elements * sizeof(Tp), default_padding));
     }
 
 public:
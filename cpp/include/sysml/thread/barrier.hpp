@@ -9,12 +9,28 @@
 // #include "dabun/isa.hpp"
 #include "sysml/assert.hpp"
 #include "sysml/thread/core.hpp"
+#include "sysml/thread/topology.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <climits>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <new>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
 
 namespace sysml::thread
 {
@@ -36,6 +52,9 @@ private:
     //     pad;
 
 public:
+    // The generation the arrival belongs to.
+    using arrival_token = std::size_t;
+
     explicit spinning_barrier(std::size_t threshold)
         : barrier_threshold(threshold)
     {
@@ -58,15 +77,38 @@ public:
             return true;
         }
 
-        while (generation.load(std::memory_order_relaxed) ==
-               generation_at_arrival)
+        wait(generation_at_arrival);
+
+        return false;
+    }
+
+    // Split phase use: arrive() returns right away, and the work done
+    // before the matching wait() overlaps with the other arrivals.  A
+    // participant has to wait for its token before arriving again.
+    arrival_token arrive()
+    {
+        auto generation_at_arrival = generation.load(std::memory_order_relaxed);
+
+        if (num_arrived.fetch_add(static_cast<std::size_t>(1)) ==
+            barrier_threshold - 1)
+        {
+            num_arrived = 0;
+
+            generation.store(generation_at_arrival + 1,
+                             std::memory_order_release);
+        }
+
+        return generation_at_arrival;
+    }
+
+    void wait(arrival_token token)
+    {
+        while (generation.load(std::memory_order_relaxed) == token)
         {
             DABUN_THREAD_CPU_RELAX();
         }
 
         std::atomic_thread_fence(std::memory_order_acquire);
-
-        return false;
     }
 };
 
@@ -88,6 +130,8 @@ public:
         SYSML_STRONG_ASSERT(threshold > 0);
     }
 
+    using arrival_token = std::size_t;
+
     bool arrive_and_wait()
     {
         std::unique_lock lock(mutex_);
@@ -111,6 +155,510 @@ public:
 
         return false;
     }
+
+    // See spinning_barrier::arrive().
+    arrival_token arrive()
+    {
+        std::unique_lock lock(mutex_);
+
+        auto generation_at_arrival = generation;
+
+        if (++num_arrived == barrier_threshold)
+        {
+            ++generation;
+            num_arrived = 0;
+            lock.unlock();
+            cv_.notify_all();
+        }
+
+        return generation_at_arrival;
+    }
+
+    void wait(arrival_token token)
+    {
+        std::unique_lock lock(mutex_);
+
+        while (generation == token)
+        {
+            cv_.wait(lock);
+        }
+    }
+};
+
+// Combining tree barrier.  Participants are grouped by their domains
+// (e.g. {package, L3 cache}) and arrivals are first combined within
+// the innermost group; only the last arrival of a group proceeds to
+// the parent node.  This keeps the contended fetch_adds local to a
+// domain.  The last arrival at the root releases everyone with a
+// single generation update.
+class alignas(hardware_destructive_interference_size) tree_barrier
+{
+private:
+    static constexpr std::size_t no_parent =
+        std::numeric_limits<std::size_t>::max();
+
+    struct alignas(hardware_destructive_interference_size) node
+    {
+        std::atomic<std::size_t> num_arrived{0};
+        std::size_t              threshold = 0;
+        std::size_t              parent    = no_parent;
+    };
+
+    struct child
+    {
+        bool        is_node;
+        std::size_t index;
+    };
+
+    std::unique_ptr<node[]>  nodes_;
+    std::vector<std::size_t> participant_node_;
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::size_t> generation{0};
+
+    // Used during construction only.
+    struct node_info
+    {
+        std::size_t threshold = 0;
+        std::size_t parent    = no_parent;
+    };
+
+    std::size_t add_node(std::vector<node_info>&   infos,
+                         std::vector<child> const& children)
+    {
+        std::size_t const idx = infos.size();
+        infos.push_back({children.size(), no_parent});
+
+        for (auto const& c : children)
+        {
+            if (c.is_node)
+            {
+                infos[c.index].parent = idx;
+            }
+            else
+            {
+                participant_node_[c.index] = idx;
+            }
+        }
+
+        return idx;
+    }
+
+    child combine(std::vector<node_info>& infos, std::vector<child> children,
+                  std::size_t fan_in)
+    {
+        while (children.size() > fan_in)
+        {
+            std::vector<child> parents;
+            for (std::size_t i = 0; i < children.size(); i += fan_in)
+            {
+                std::vector<child> group(
+                    children.begin() + i,
+                    children.begin() + std::min(i + fan_in, children.size()));
+                parents.push_back({true, add_node(infos, group)});
+            }
+            children = std::move(parents);
+        }
+
+        if (children.size() == 1 && children[0].is_node)
+        {
+            return children[0];
+        }
+
+        return {true, add_node(infos, children)};
+    }
+
+    child build(std::vector<node_info>&                      infos,
+                std::vector<std::vector<std::size_t>> const& domains,
+                std::vector<std::size_t> const& members, std::size_t depth,
+                std::size_t fan_in)
+    {
+        std::map<std::size_t, std::vector<std::size_t>> groups;
+        bool                                            leaf = true;
+
+        for (auto m : members)
+        {
+            if (depth < domains[m].size())
+            {
+                groups[domains[m][depth]].push_back(m);
+                leaf = false;
+            }
+        }
+
+        if (leaf)
+        {
+            std::vector<child> children;
+            for (auto m : members)
+            {
+                children.push_back({false, m});
+            }
+            return combine(infos, std::move(children), fan_in);
+        }
+
+        SYSML_STRONG_ASSERT(groups.size() > 0);
+
+        if (groups.size() == 1)
+        {
+            return build(infos, domains, members, depth + 1, fan_in);
+        }
+
+        std::vector<child> children;
+        for (auto const& g : groups)
+        {
+            children.push_back(build(infos, domains, g.second, depth + 1,
+                                     fan_in));
+        }
+
+        return combine(infos, std::move(children), fan_in);
+    }
+
+    void initialize(std::vector<std::vector<std::size_t>> const& domains,
+                    std::size_t                                  fan_in)
+    {
+        SYSML_STRONG_ASSERT(domains.size() > 0);
+        SYSML_STRONG_ASSERT(fan_in > 1);
+
+        participant_node_.resize(domains.size());
+
+        std::vector<std::size_t> members(domains.size());
+        for (std::size_t i = 0; i < members.size(); ++i)
+        {
+            members[i] = i;
+        }
+
+        std::vector<node_info> infos;
+        build(infos, domains, members, 0, fan_in);
+
+        nodes_ = std::make_unique<node[]>(infos.size());
+        for (std::size_t i = 0; i < infos.size(); ++i)
+        {
+            nodes_[i].threshold = infos[i].threshold;
+            nodes_[i].parent    = infos[i].parent;
+        }
+    }
+
+public:
+    static constexpr std::size_t default_fan_in = 4;
+
+    // Participant i belongs to the nested domains domains[i], listed
+    // from the outermost to the innermost (e.g. {package, L3 cache}).
+    explicit tree_barrier(std::vector<std::vector<std::size_t>> const& domains,
+                          std::size_t fan_in = default_fan_in)
+    {
+        initialize(domains, fan_in);
+    }
+
+    // Plain fan_in-ary combining tree.
+    explicit tree_barrier(std::size_t threshold,
+                          std::size_t fan_in = default_fan_in)
+    {
+        SYSML_STRONG_ASSERT(threshold > 0);
+        initialize(std::vector<std::vector<std::size_t>>(threshold), fan_in);
+    }
+
+    // Participant i runs on cpu_ids[i]; participants are grouped by
+    // their package and L3 cache.
+    explicit tree_barrier(
+        std::vector<int> const& cpu_ids,
+        cpu_topology const&     topology = cpu_topology::host(),
+        std::size_t             fan_in   = default_fan_in)
+    {
+        std::vector<std::vector<std::size_t>> domains;
+        for (auto cpu : cpu_ids)
+        {
+            if (topology.contains(cpu))
+            {
+                auto const& info = topology.cpu(cpu);
+                domains.push_back({static_cast<std::size_t>(info.package),
+                                   static_cast<std::size_t>(info.l3_group)});
+            }
+            else
+            {
+                domains.push_back({});
+            }
+        }
+        initialize(domains, fan_in);
+    }
+
+    std::size_t threshold() const noexcept { return participant_node_.size(); }
+
+    using arrival_token = std::size_t;
+
+private:
+    // Combines the arrival up the tree; returns true for the last
+    // arrival, which released everyone.
+    bool combine_arrival(std::size_t participant,
+                         std::size_t generation_at_arrival)
+    {
+        assert(participant < participant_node_.size());
+
+        for (auto n = participant_node_[participant];;)
+        {
+            auto& nd = nodes_[n];
+
+            if (nd.num_arrived.fetch_add(static_cast<std::size_t>(1),
+                                         std::memory_order_acq_rel) !=
+                nd.threshold - 1)
+            {
+                return false;
+            }
+
+            // Last arrival at this node
+            nd.num_arrived.store(0, std::memory_order_relaxed);
+
+            if (nd.parent == no_parent)
+            {
+                generation.store(generation_at_arrival + 1,
+                                 std::memory_order_release);
+                return true;
+            }
+
+            n = nd.parent;
+        }
+    }
+
+public:
+    bool arrive_and_wait(std::size_t participant)
+    {
+        auto generation_at_arrival = generation.load(std::memory_order_relaxed);
+
+        if (combine_arrival(participant, generation_at_arrival))
+        {
+            return true;
+        }
+
+        wait(generation_at_arrival);
+
+        return false;
+    }
+
+    // See spinning_barrier::arrive().
+    arrival_token arrive(std::size_t participant)
+    {
+        auto generation_at_arrival = generation.load(std::memory_order_relaxed);
+        combine_arrival(participant, generation_at_arrival);
+        return generation_at_arrival;
+    }
+
+    void wait(arrival_token token)
+    {
+        while (generation.load(std::memory_order_relaxed) == token)
+        {
+            DABUN_THREAD_CPU_RELAX();
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+};
+
+namespace detail
+{
+
+inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected)
+{
+#if defined(__linux__)
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+            FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    word.wait(expected);
+#endif
+}
+
+inline void futex_wake_all(std::atomic<std::uint32_t>& word)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+            FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    word.notify_all();
+#endif
+}
+
+inline void futex_wake_one(std::atomic<std::uint32_t>& word)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+            FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    word.notify_one();
+#endif
+}
+
+} // namespace detail
+
+// Spins on DABUN_THREAD_CPU_RELAX() for a bounded number of iterations,
+// then parks on a futex.  The spin budget adapts to the observed
+// waiting times: waits that would have been covered by spinning for
+// max_spin_time pull the budget towards twice their length, longer
+// waits (e.g. idle time between bursts of work) pull it towards zero,
+// so that idle waiters go to sleep right away.
+class alignas(hardware_destructive_interference_size) hybrid_barrier
+{
+private:
+    alignas(hardware_constructive_interference_size) std::size_t const
+        barrier_threshold;
+    double const       iterations_per_microsecond;
+    std::int64_t const max_spin;
+
+    alignas(hardware_constructive_interference_size)
+        std::atomic<std::size_t> num_arrived{0};
+
+    alignas(hardware_constructive_interference_size)
+        std::atomic<std::uint32_t> generation{0};
+
+    alignas(hardware_constructive_interference_size)
+        std::atomic<std::uint32_t> num_sleepers{0};
+
+    alignas(hardware_constructive_interference_size)
+        std::atomic<std::int64_t> spin_budget;
+
+    void update_spin_budget(std::int64_t waited)
+    {
+        auto budget = spin_budget.load(std::memory_order_relaxed);
+        auto target = waited <= max_spin ? std::min(2 * waited, max_spin)
+                                         : static_cast<std::int64_t>(0);
+        spin_budget.store(budget + (target - budget) / 8,
+                          std::memory_order_relaxed);
+    }
+
+public:
+    static constexpr std::chrono::microseconds default_max_spin_time{50};
+
+    explicit hybrid_barrier(
+        std::size_t               threshold,
+        std::chrono::microseconds max_spin_time = default_max_spin_time)
+        : barrier_threshold(threshold)
+        , iterations_per_microsecond(cpu_relax_iterations_per_microsecond())
+        , max_spin(static_cast<std::int64_t>(
+              static_cast<double>(max_spin_time.count()) *
+              iterations_per_microsecond))
+        , spin_budget(max_spin)
+    {
+        SYSML_STRONG_ASSERT(threshold > 0);
+    }
+
+    // Current number of DABUN_THREAD_CPU_RELAX() iterations before parking
+    std::int64_t current_spin_budget() const noexcept
+    {
+        return spin_budget.load(std::memory_order_relaxed);
+    }
+
+    using arrival_token = std::uint32_t;
+
+private:
+    // Returns true for the last arrival, which released everyone.
+    bool release_if_last(std::uint32_t generation_at_arrival)
+    {
+        if (num_arrived.fetch_add(static_cast<std::size_t>(1)) !=
+            barrier_threshold - 1)
+        {
+            return false;
+        }
+
+        num_arrived = 0;
+
+        generation.store(generation_at_arrival + 1);
+
+        if (num_sleepers.load() > 0)
+        {
+            detail::futex_wake_all(generation);
+        }
+
+        return true;
+    }
+
+public:
+    bool arrive_and_wait()
+    {
+        auto generation_at_arrival = generation.load(std::memory_order_relaxed);
+
+        if (release_if_last(generation_at_arrival))
+        {
+            return true;
+        }
+
+        wait(generation_at_arrival);
+
+        return false;
+    }
+
+    // See spinning_barrier::arrive().  Time spent between arrive() and
+    // wait() doesn't count as waiting for the spin budget.
+    arrival_token arrive()
+    {
+        auto generation_at_arrival = generation.load(std::memory_order_relaxed);
+        release_if_last(generation_at_arrival);
+        return generation_at_arrival;
+    }
+
+    void wait(arrival_token token)
+    {
+        auto const budget = spin_budget.load(std::memory_order_relaxed);
+
+        for (std::int64_t spins = 0; spins < budget; ++spins)
+        {
+            if (generation.load(std::memory_order_relaxed) != token)
+            {
+                update_spin_budget(spins);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return;
+            }
+
+            DABUN_THREAD_CPU_RELAX();
+        }
+
+        auto park_start = std::chrono::steady_clock::now();
+
+        num_sleepers.fetch_add(1);
+
+        while (generation.load() == token)
+        {
+            detail::futex_wait(generation, token);
+        }
+
+        num_sleepers.fetch_sub(1, std::memory_order_relaxed);
+
+        std::chrono::duration<double, std::micro> parked =
+            std::chrono::steady_clock::now() - park_start;
+
+        update_spin_budget(
+            budget + static_cast<std::int64_t>(parked.count() *
+                                               iterations_per_microsecond));
+    }
 };
 
+// Calls barrier.arrive_and_wait(participant) for barriers that need to
+// know the participant (e.g. tree_barrier), and
+// barrier.arrive_and_wait() otherwise.
+template <class Barrier>
+__attribute__((always_inline)) inline bool
+arrive_and_wait(Barrier& barrier, [[maybe_unused]] std::size_t participant)
+{
+    if constexpr (requires { barrier.arrive_and_wait(participant); })
+    {
+        return barrier.arrive_and_wait(participant);
+    }
+    else
+    {
+        return barrier.arrive_and_wait();
+    }
+}
+
+// Split phase counterpart of arrive_and_wait(barrier, participant);
+// the token is then passed to barrier.wait().
+template <class Barrier>
+__attribute__((always_inline)) inline auto
+arrive(Barrier& barrier, [[maybe_unused]] std::size_t participant)
+{
+    if constexpr (requires { barrier.arrive(participant); })
+    {
+        return barrier.arrive(participant);
+    }
+    else
+    {
+        return barrier.arrive();
+    }
+}
+
 } // namespace sysml::thread
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
 
 #if defined(__aarch64__)
@@ -32,4 +34,30 @@ struct hardware_constructive_interference_padding
                  sizeof(T)]; // = {'\0'};
 };
 
+// Number of DABUN_THREAD_CPU_RELAX() iterations per microsecond, measured
+// once per process.
+inline double cpu_relax_iterations_per_microsecond()
+{
+    static double const ret = []()
+    {
+        constexpr int iterations = 1 << 14;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            DABUN_THREAD_CPU_RELAX();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        auto nsecs =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                .count();
+
+        return static_cast<double>(iterations) * 1000.0 /
+               static_cast<double>(std::max(nsecs, decltype(nsecs)(1)));
+    }();
+
+    return ret;
+}
+
 } // namespace sysml::thread
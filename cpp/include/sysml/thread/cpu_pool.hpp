@@ -12,17 +12,28 @@
 
 #include "sysml/thread/barrier.hpp"
 #include "sysml/thread/core.hpp"
+#include "sysml/thread/cpu_pool_counters.hpp"
 #include "sysml/thread/cpu_set.hpp"
+#include "sysml/thread/mpmc_queue.hpp"
+#include "sysml/thread/placement.hpp"
+#include "sysml/thread/scratch_arena.hpp"
+#include "sysml/thread/submitted_batch.hpp"
+#include "sysml/thread/work_stealing_deque.hpp"
 
 #include <sched.h>
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <limits>
 #include <memory>
 #include <numeric>
 #include <optional>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace sysml::thread
@@ -31,6 +42,63 @@ namespace sysml::thread
 struct cpu_context
 {
     std::size_t cpu_index;
+
+    // The worker's own arena for temporary buffers; everything
+    // allocated from it is released when the execute is done.
+    scratch_arena* scratch = nullptr;
+
+    // Barrier of all the workers of the pool, for multi phase tasks.
+    // Every worker has to arrive equally often during an execute (as
+    // in execute_on_all_cpus), and wait for every arrive before its
+    // task returns.  Not usable from execute_async, which the owner's
+    // thread doesn't take part in.
+    spinning_barrier* barrier = nullptr;
+
+    bool arrive_and_wait() const { return barrier->arrive_and_wait(); }
+
+    // Split phase: work done between arrive() and wait() overlaps with
+    // the other workers' arrivals.
+    spinning_barrier::arrival_token arrive() const { return barrier->arrive(); }
+
+    void wait(spinning_barrier::arrival_token token) const
+    {
+        barrier->wait(token);
+    }
+};
+
+// What the workers do between executes, and between submitted tasks
+// in serving mode.  By default they keep spinning on the dispatch
+// barrier (or the submission queue), which gives the lowest dispatch
+// latency but keeps their cpus busy.  Otherwise they spin for a while
+// after every execute (or task) and then park themselves until the
+// next one; waking them up adds the latency of a futex wake to it.
+struct idle_policy
+{
+    static constexpr std::chrono::microseconds never_park =
+        std::chrono::microseconds::max();
+
+    static constexpr std::chrono::microseconds default_max_spin_time{50};
+
+    // How long to spin before parking.
+    std::chrono::microseconds spin_time = never_park;
+
+    // Adapt the spin window to the observed gaps between executes,
+    // within [0, spin_time]: gaps the window would have covered pull
+    // it towards twice their length, longer ones towards zero.
+    bool adaptive = false;
+
+    static idle_policy always_spin() { return {}; }
+
+    static idle_policy park_after(std::chrono::microseconds spin_time)
+    {
+        return {spin_time, false};
+    }
+
+    static idle_policy adaptive_park(
+        std::chrono::microseconds max_spin_time = default_max_spin_time)
+    {
+        return {max_spin_time, true};
+    }
 };
 
 class thread_owner_enforcer
@@ -44,14 +112,28 @@ public:
     {
     }
 
-    void enforce()
+    bool is_owner() const
     {
-        SYSML_STRONG_ASSERT(thread_id_ == std::this_thread::get_id());
+        return thread_id_ == std::this_thread::get_id();
     }
+
+    void enforce() { SYSML_STRONG_ASSERT(is_owner()); }
 };
 
-class alignas(hardware_destructive_interference_size) cpu_pool
+// DispatchBarrier is the barrier the workers synchronize on before and
+// after every execute (spinning_barrier, tree_barrier, ...).
+template <class DispatchBarrier = spinning_barrier>
+class alignas(hardware_destructive_interference_size) basic_cpu_pool
 {
+public:
+    // Batches queued and not yet taken by a worker.  submit() blocks
+    // while the queue is full, which only ends when someone drains it:
+    // the serving workers, or the owner through run_submitted().  When
+    // neither can, i.e. the pool is not in serving mode (or has a
+    // single worker), submit() throws rather than waiting forever; on
+    // the owner's thread it runs the queued batches itself instead.
+    static constexpr std::size_t submission_queue_capacity = 1024;
+
 private:
     static constexpr std::size_t all_execute_the_same =
         std::numeric_limits<std::size_t>::max();
@@ -61,19 +143,39 @@ private:
     std::size_t /* , hardware_destructive_interference_size >*/ const size_;
     cpu_set               original_cpu_set_;
     bool                  restore_original_cpu_set_ = false;
+    std::vector<int>      cpu_ids_;
     thread_owner_enforcer enforcer_;
     cpu_context           zeroth_cpu_context_{0};
 
     alignas(hardware_destructive_interference_size)
-        spinning_barrier spinning_barrier_;
+        DispatchBarrier dispatch_barrier_;
 
     alignas(hardware_destructive_interference_size)
         default_barrier sleeping_barrier_;
 
+    // Reached by the tasks through cpu_context::barrier.
+    alignas(hardware_destructive_interference_size)
+        spinning_barrier task_barrier_;
+
     alignas(hardware_destructive_interference_size)
         std::function<void(cpu_context const&)> const* tasks_ = nullptr;
     std::size_t tasks_size_                                   = 0;
 
+    // Set by the templated execute(); a pointer to the caller's
+    // callable and a function that runs the worker's share of the
+    // indices, so that no std::function (and no allocation) is involved.
+    using range_task_invoker_type = void (*)(void const*, cpu_context const&,
+                                             std::size_t, std::size_t,
+                                             std::size_t);
+
+    void const*             range_task_         = nullptr;
+    range_task_invoker_type range_task_invoker_ = nullptr;
+
+    // Set while an execute_async is in flight; the owner thread is not
+    // taking part, and the workers count themselves done.
+    bool                     async_pending_ = false;
+    std::atomic<std::size_t> async_finished_{0};
+
     alignas(hardware_destructive_interference_size)
         std::function<void(cpu_context const&)> const sleep_function_;
 
@@ -82,6 +184,201 @@ private:
 
     alignas(hardware_destructive_interference_size) bool is_sleeping_ = false;
 
+    // Batches submitted from arbitrary threads, drained by the workers
+    // while the pool is in serving mode.
+    mpmc_queue<submitted_batch> submitted_;
+
+    // Bumped after every submission, and when serving stops; the idle
+    // serving workers park on it (see idle_policy).
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::uint32_t> submit_epoch_{0};
+    std::atomic<std::uint32_t>     num_serving_parked_{0};
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<bool> keep_serving_{false};
+
+    std::function<void(cpu_context const&)> const serve_function_;
+
+    std::vector<std::function<void(cpu_context const&)>> const
+        serve_function_tasks_;
+
+    bool is_serving_ = false;
+
+    // Whether the owner put the pool in serving mode (with workers to
+    // serve); unlike is_serving_, it stays set while an execute
+    // suspends serving.  Read by the submitting threads.
+    std::atomic<bool> drained_by_workers_{false};
+
+    // The modes an execute leaves for its duration.
+    struct suspended_modes
+    {
+        bool sleeping;
+        bool serving;
+    };
+
+    suspended_modes async_modes_{false, false};
+
+    // One deque per worker, used by the work-stealing loops.
+    std::unique_ptr<work_stealing_deque[]> deques_;
+
+    std::unique_ptr<scratch_arena[]> scratch_arenas_;
+
+    // Idle parking (see idle_policy).  The owner bumps the epoch
+    // before releasing the workers from the dispatch barrier, and
+    // wakes the ones parked on it.  The spin limit is in
+    // DABUN_THREAD_CPU_RELAX() iterations, negative for never parking.
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::uint32_t> dispatch_epoch_{0};
+    std::atomic<std::uint32_t>     num_parked_{0};
+    std::atomic<std::int64_t>      idle_spin_limit_{-1};
+    std::atomic<bool>              idle_adaptive_{false};
+    idle_policy                    idle_policy_;
+
+    // Only updated with SYSML_THREAD_CPU_POOL_COUNTERS defined.  The
+    // baseline is what the workers had counted at the last
+    // reset_counters(); only the owner touches it.
+    detail::worker_counter_array<>   counters_;
+    std::vector<cpu_worker_counters> counters_baseline_;
+    detail::counter_type             sleep_transitions_{0};
+    detail::counter_type             wake_transitions_{0};
+
+    std::vector<std::thread> workers_;
+
+    using ns_counter = detail::scoped_ns_counter<>;
+
+    // Number of the indices first, first + stride, ... below last.
+    static std::size_t num_range_tasks(std::size_t first, std::size_t last,
+                                       std::size_t stride) noexcept
+    {
+        return first < last ? (last - first + stride - 1) / stride : 0;
+    }
+
+    template <class Fn>
+    static void invoke_range_task(void const* fn, cpu_context const& ctx,
+                                  std::size_t first, std::size_t last,
+                                  std::size_t stride)
+    {
+        auto const& task = *static_cast<Fn const*>(fn);
+        for (std::size_t i = first; i < last; i += stride)
+        {
+            task(ctx, i);
+        }
+    }
+
+    bool dispatch_arrive_and_wait(std::size_t participant)
+    {
+        return arrive_and_wait(dispatch_barrier_, participant);
+    }
+
+    // The owner's arrival at the barrier the workers wait on between
+    // executes.
+    void release_workers()
+    {
+        dispatch_epoch_.fetch_add(1);
+        if (num_parked_.load() > 0)
+        {
+            detail::futex_wake_all(dispatch_epoch_);
+        }
+        dispatch_arrive_and_wait(0);
+    }
+
+    // A worker's adaptive spin window.
+    struct idle_state
+    {
+        std::int64_t limit  = -1;
+        std::int64_t budget = -1;
+
+        void update(std::int64_t waited)
+        {
+            auto target = waited <= limit ? std::min(2 * waited, limit)
+                                          : static_cast<std::int64_t>(0);
+            budget += (target - budget) / 8;
+        }
+    };
+
+    // Returns once the epoch has moved past seen, spinning and then
+    // parking on it as the idle policy says; num_parked counts the
+    // workers parked on the epoch.  Returns right away when never parking; the
+    // worker then spins elsewhere instead.
+    void wait_for_epoch(std::size_t idx, std::atomic<std::uint32_t>& epoch,
+                        std::atomic<std::uint32_t>& num_parked,
+                        std::uint32_t seen, idle_state& state)
+    {
+        auto const limit = idle_spin_limit_.load(std::memory_order_relaxed);
+
+        if (limit < 0)
+        {
+            return;
+        }
+
+        if (limit != state.limit)
+        {
+            state.limit  = limit;
+            state.budget = limit;
+        }
+
+        bool const adaptive = idle_adaptive_.load(std::memory_order_relaxed);
+        auto const budget   = adaptive ? state.budget : limit;
+        auto&      counters = counters_[idx];
+
+        {
+            ns_counter idle(counters.idle_ns);
+
+            for (std::int64_t spins = 0; spins < budget; ++spins)
+            {
+                if (epoch.load(std::memory_order_relaxed) != seen)
+                {
+                    state.update(spins);
+                    return;
+                }
+
+                DABUN_THREAD_CPU_RELAX();
+            }
+        }
+
+        if (epoch.load() != seen)
+        {
+            return;
+        }
+
+        ns_counter sleeping(counters.sleep_ns);
+        detail::add_to_counter(counters.sleeps, 1);
+
+        auto const park_start = std::chrono::steady_clock::now();
+
+        num_parked.fetch_add(1);
+
+        while (epoch.load() == seen)
+        {
+            detail::futex_wait(epoch, seen);
+        }
+
+        num_parked.fetch_sub(1, std::memory_order_relaxed);
+
+        std::chrono::duration<double, std::micro> const parked =
+            std::chrono::steady_clock::now() - park_start;
+
+        auto const parked_spins = static_cast<std::int64_t>(
+            parked.count() * cpu_relax_iterations_per_microsecond());
+
+        state.update(budget + parked_spins);
+    }
+
+    static DispatchBarrier
+    make_dispatch_barrier(std::size_t                              s,
+                          [[maybe_unused]] std::vector<int> const* cpu_ids_ptr)
+    {
+        if constexpr (std::is_constructible_v<DispatchBarrier,
+                                              std::vector<int> const&>)
+        {
+            if (cpu_ids_ptr != nullptr)
+            {
+                return DispatchBarrier(*cpu_ids_ptr);
+            }
+        }
+        return DispatchBarrier(s);
+    }
+
     void cpu_working_loop(std::size_t idx, std::optional<int> cpu_id)
     {
         if (cpu_id) // Has to bind to a particular core
@@ -89,30 +386,82 @@ private:
             bind_to_core(*cpu_id);
         }
 
-        cpu_context working_cpu_context = {idx};
+        cpu_context working_cpu_context = {idx, &scratch_arenas_[idx],
+                                           &task_barrier_};
 
         // Signal to the constructor that we are done initializing
-        spinning_barrier_.arrive_and_wait();
+        dispatch_arrive_and_wait(idx);
+
+        auto& counters = counters_[idx];
+
+        std::uint32_t released = 0;
+        idle_state    idle;
 
         do
         {
-            // Wait for a kernel;
-            spinning_barrier_.arrive_and_wait();
+            // Wait for a kernel; the owner bumps the dispatch epoch
+            // when it starts releasing the workers.
+            wait_for_epoch(idx, dispatch_epoch_, num_parked_, released, idle);
+
+            {
+                ns_counter idle_wait(counters.idle_ns);
+                dispatch_arrive_and_wait(idx);
+            }
+
+            ++released;
 
+            detail::add_to_counter(counters.dispatches, 1);
+
+            if (range_task_ != nullptr)
+            {
+                ns_counter busy(counters.busy_ns);
+
+                if (async_pending_)
+                {
+                    range_task_invoker_(range_task_, working_cpu_context,
+                                        idx - 1, tasks_size_, size_ - 1);
+                    detail::add_to_counter(
+                        counters.tasks,
+                        num_range_tasks(idx - 1, tasks_size_, size_ - 1));
+                    async_finished_.fetch_add(1, std::memory_order_release);
+                }
+                else
+                {
+                    range_task_invoker_(range_task_, working_cpu_context, idx,
+                                        tasks_size_, size_);
+                    detail::add_to_counter(
+                        counters.tasks,
+                        num_range_tasks(idx, tasks_size_, size_));
+                }
+            }
             // Special case indicating that we need to exit the loop
-            if (tasks_ == nullptr)
+            else if (tasks_ == nullptr)
             {
                 // We don't really need to reset the affinity, as the
                 // thread will be exiting.  We just indicate the
                 // completion of the loop.
-                spinning_barrier_.arrive_and_wait();
+                dispatch_arrive_and_wait(idx);
                 return;
             }
+            else if (tasks_ == sleep_function_tasks_.data())
+            {
+                ns_counter sleeping(counters.sleep_ns);
+                detail::add_to_counter(counters.sleeps, 1);
+                tasks_[idx](working_cpu_context);
+            }
+            else if (tasks_ == serve_function_tasks_.data())
+            {
+                // Counted task by task by serve_submitted.
+                tasks_[idx](working_cpu_context);
+            }
             else
             {
+                ns_counter busy(counters.busy_ns);
+
                 if (tasks_size_ == all_execute_the_same)
                 {
                     tasks_[0](working_cpu_context);
+                    detail::add_to_counter(counters.tasks, 1);
                 }
                 else
                 {
@@ -120,6 +469,9 @@ private:
                     {
                         tasks_[i](working_cpu_context);
                     }
+                    detail::add_to_counter(
+                        counters.tasks,
+                        num_range_tasks(idx, tasks_size_, size_));
                 }
             }
 
@@ -128,8 +480,11 @@ private:
             //     tasks_[idx]();
             // }
 
+            working_cpu_context.scratch->reset();
+
             {
-                spinning_barrier_.arrive_and_wait();
+                ns_counter barrier_wait(counters.barrier_wait_ns);
+                dispatch_arrive_and_wait(idx);
             }
 
         } while (true);
@@ -138,13 +493,185 @@ private:
 public:
     std::size_t size() const noexcept { return size_; }
 
+    // The cpu each worker is bound to; empty for pools that don't bind
+    // their workers.
+    std::vector<int> const& cpu_ids() const noexcept { return cpu_ids_; }
+
+    work_stealing_deque& local_deque(std::size_t cpu_index) noexcept
+    {
+        assert(cpu_index < size_);
+        return deques_[cpu_index];
+    }
+
+    scratch_arena& local_scratch(std::size_t cpu_index) noexcept
+    {
+        assert(cpu_index < size_);
+        return scratch_arenas_[cpu_index];
+    }
+
+    // Where the workers spent their time since construction or the
+    // last reset_counters(); all zeros unless the pool is compiled with
+    // SYSML_THREAD_CPU_POOL_COUNTERS.  Exact when taken between
+    // executes.
+    cpu_pool_counters counters() const
+    {
+        cpu_pool_counters ret;
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            auto const now = counters_[i].snapshot();
+            ret.workers.push_back(
+                counters_baseline_.empty()
+                    ? now
+                    : detail::counted_since(now, counters_baseline_[i]));
+        }
+        ret.sleep_transitions = sleep_transitions_.load();
+        ret.wake_transitions  = wake_transitions_.load();
+        return ret;
+    }
+
+    // Starts counting from zero.  The workers' counters are left to
+    // their workers, which may be updating them (e.g. while serving);
+    // the counts so far are remembered and taken off the later
+    // snapshots instead.  An interval a worker is in the middle of
+    // timing (e.g. waiting idle for the next execute) is counted in
+    // full when it ends, including its part from before the reset.
+    void reset_counters()
+    {
+        enforcer_.enforce();
+
+        if constexpr (cpu_pool_counters_enabled)
+        {
+            counters_baseline_.resize(size_);
+            for (std::size_t i = 0; i < size_; ++i)
+            {
+                counters_baseline_[i] = counters_[i].snapshot();
+            }
+        }
+        sleep_transitions_ = 0;
+        wake_transitions_  = 0;
+    }
+
+    // Grows every worker's scratch arena to at least bytes; the
+    // workers allocate and touch their own buffers, so the pages are
+    // local to their NUMA nodes.
+    void reserve_scratch(std::size_t bytes)
+    {
+        execute_on_all_cpus([bytes](cpu_context const& ctx)
+                            { ctx.scratch->reserve(bytes); });
+    }
+
 private:
+    void serve_submitted(cpu_context const& ctx)
+    {
+        idle_state idle;
+
+        while (keep_serving_.load(std::memory_order_relaxed))
+        {
+            // Read before the queue is found empty, so that a
+            // submission in between isn't slept through.
+            auto const seen = submit_epoch_.load();
+
+            if (auto batch = submitted_.try_pop())
+            {
+                share_batch(*batch);
+
+                ns_counter busy(counters_[ctx.cpu_index].busy_ns);
+                (*batch)(ctx);
+                ctx.scratch->reset();
+                detail::add_to_counter(counters_[ctx.cpu_index].tasks,
+                                       batch->size());
+            }
+            else
+            {
+                DABUN_THREAD_CPU_RELAX();
+                wait_for_epoch(ctx.cpu_index, submit_epoch_,
+                               num_serving_parked_, seen, idle);
+            }
+        }
+    }
+
+    // Guided split of a batch taken off the queue: keeps a share of
+    // its tasks for one of the serving workers, and queues the rest
+    // back for the others.  Each later share is smaller, balancing the
+    // tail of the batch.  Keeps the whole batch when the queue is full.
+    void share_batch(submitted_batch& batch)
+    {
+        auto const num_serving = size_ - 1;
+
+        if (num_serving < 2 || batch.size() < 2)
+        {
+            return;
+        }
+
+        auto const share = (batch.size() + num_serving - 1) / num_serving;
+        auto const split = batch.first() + share;
+
+        if (split < batch.last() &&
+            submitted_.try_push(batch.slice(split, batch.last())))
+        {
+            batch.truncate(split);
+            notify_submitted();
+        }
+    }
+
+    // A submitted task is waiting; wakes a parked serving worker.
+    void notify_submitted()
+    {
+        submit_epoch_.fetch_add(1);
+        if (num_serving_parked_.load() > 0)
+        {
+            detail::futex_wake_one(submit_epoch_);
+        }
+    }
+
+    // The owner's part of an execute: releases the workers, runs its
+    // own share of num_tasks tasks and waits for the others.
+    template <class Fn>
+    void run_owner_share(std::size_t num_tasks, Fn const& share)
+    {
+        auto& counters = counters_[0];
+
+        {
+            ns_counter barrier_wait(counters.barrier_wait_ns);
+            release_workers();
+        }
+
+        detail::add_to_counter(counters.dispatches, 1);
+
+        {
+            ns_counter busy(counters.busy_ns);
+            share();
+        }
+
+        detail::add_to_counter(counters.tasks, num_tasks);
+
+        {
+            ns_counter barrier_wait(counters.barrier_wait_ns);
+            dispatch_arrive_and_wait(0);
+        }
+
+        scratch_arenas_[0].reset();
+    }
+
+    suspended_modes suspend_modes()
+    {
+        bool const was_serving = switch_serving_mode(false);
+        return {set_sleeping_mode(false), was_serving};
+    }
+
+    void restore_modes(suspended_modes modes)
+    {
+        set_sleeping_mode(modes.sleeping);
+        switch_serving_mode(modes.serving);
+    }
+
     void initialize_workers(std::vector<int> const* cpu_ids_ptr)
     {
         // Bind the main thread
         if (cpu_ids_ptr != nullptr)
         {
             restore_original_cpu_set_ = true;
+            cpu_ids_                  = *cpu_ids_ptr;
             get_affinity(original_cpu_set_);
             bind_to_core(cpu_ids_ptr->operator[](0));
         }
@@ -153,50 +680,61 @@ private:
         // TODO(zi) Special pathway for operating set with only one worker.
         // SYSML_STRONG_ASSERT(size() > 1);
 
+        workers_.reserve(size() - 1);
+
         for (std::size_t idx = 1; idx < size(); ++idx)
         {
             if (cpu_ids_ptr != nullptr)
             {
-                std::thread worker(&cpu_pool::cpu_working_loop, this, idx,
-                                   cpu_ids_ptr->operator[](idx));
-                worker.detach();
+                workers_.emplace_back(&basic_cpu_pool::cpu_working_loop, this,
+                                      idx, cpu_ids_ptr->operator[](idx));
             }
             else
             {
-                std::thread worker(&cpu_pool::cpu_working_loop, this, idx,
-                                   std::nullopt);
-                worker.detach();
+                workers_.emplace_back(&basic_cpu_pool::cpu_working_loop, this,
+                                      idx, std::nullopt);
             }
         }
 
         // Wait for all workers to signal being initialized
-        spinning_barrier_.arrive_and_wait();
+        dispatch_arrive_and_wait(0);
     }
 
     struct basic_constructor_tag
     {
     };
 
-    cpu_pool(basic_constructor_tag, std::size_t s)
+    basic_cpu_pool(basic_constructor_tag, std::size_t s,
+                   std::vector<int> const* cpu_ids_ptr)
         : size_(s)
-        , spinning_barrier_(size_)
+        , dispatch_barrier_(make_dispatch_barrier(s, cpu_ids_ptr))
         , sleeping_barrier_(size_)
+        , task_barrier_(size_)
         , tasks_(nullptr)
         , sleep_function_([this](cpu_context const&)
                           { this->sleeping_barrier_.arrive_and_wait(); })
         , sleep_function_tasks_(size_, sleep_function_)
+        , submitted_(submission_queue_capacity)
+        , serve_function_([this](cpu_context const& ctx)
+                          { this->serve_submitted(ctx); })
+        , serve_function_tasks_(size_, serve_function_)
+        , deques_(std::make_unique<work_stealing_deque[]>(size_))
+        , scratch_arenas_(std::make_unique<scratch_arena[]>(size_))
+        , counters_(size_)
     {
+        zeroth_cpu_context_.scratch = &scratch_arenas_[0];
+        zeroth_cpu_context_.barrier = &task_barrier_;
     }
 
 public:
-    explicit cpu_pool(std::vector<int> const& cpu_ids)
-        : cpu_pool(basic_constructor_tag{}, cpu_ids.size())
+    explicit basic_cpu_pool(std::vector<int> const& cpu_ids)
+        : basic_cpu_pool(basic_constructor_tag{}, cpu_ids.size(), &cpu_ids)
     {
         initialize_workers(&cpu_ids);
     }
 
-    explicit cpu_pool(std::size_t num_cpus, bool bind_to_cores = false)
-        : cpu_pool(basic_constructor_tag{}, num_cpus)
+    explicit basic_cpu_pool(std::size_t num_cpus, bool bind_to_cores = false)
+        : basic_cpu_pool(basic_constructor_tag{}, num_cpus, nullptr)
     {
         if (bind_to_cores)
         {
@@ -211,15 +749,42 @@ public:
         }
     }
 
+    // Pins the workers to the first num_cpus cpus of the placement,
+    // chosen among the cpus the calling thread is allowed to run on.
+    template <class Placement,
+              class = std::enable_if_t<is_placement_v<Placement>>>
+    basic_cpu_pool(std::size_t num_cpus, Placement placement)
+        : basic_cpu_pool(
+              place_cpus(available_cpu_topology(), num_cpus, placement))
+    {
+    }
+
+    // One worker per cpu of the placement, among the cpus the calling
+    // thread is allowed to run on.
+    template <class Placement,
+              class = std::enable_if_t<is_placement_v<Placement>>>
+    explicit basic_cpu_pool(Placement placement)
+        : basic_cpu_pool(place_cpus(available_cpu_topology(), placement))
+    {
+    }
+
     bool set_sleeping_mode(bool sleep_mode)
     {
         enforcer_.enforce();
 
+        // No execute can be issued while an execute_async is pending.
+        SYSML_STRONG_ASSERT(!async_pending_);
+
         if (sleep_mode == is_sleeping_)
         {
             return sleep_mode;
         }
 
+        if (sleep_mode)
+        {
+            set_serving_mode(false);
+        }
+
         if (is_sleeping_) // Needs to go into spinning mode, which is
                           // just signaling the sleeping thread on
                           // which all other threads are waiting.
@@ -240,9 +805,10 @@ public:
             // Sync after being done with the tasks
             // TODO(zi) Optimize this - we don't need the spinning
             // barrier sync in this particular pathway.
-            spinning_barrier_.arrive_and_wait();
+            dispatch_arrive_and_wait(0);
 
             is_sleeping_ = false;
+            detail::add_to_counter(wake_transitions_, 1);
             return true;
         }
         else // Needs to go into sleeping mode
@@ -255,26 +821,248 @@ public:
 
             // All other threads started the task [and the task is to
             // wait on the sleeping barrier :)_
-            spinning_barrier_.arrive_and_wait();
+            release_workers();
 
             is_sleeping_ = true;
+            detail::add_to_counter(sleep_transitions_, 1);
             return false;
         }
     }
 
     void to_sleeping_mode() { set_sleeping_mode(true); }
 
+    // Takes effect from the next time the workers go idle.
+    void set_idle_policy(idle_policy policy)
+    {
+        enforcer_.enforce();
+
+        SYSML_THROW_ASSERT(policy.spin_time.count() >= 0)
+            << "Negative idle spin time " << policy.spin_time.count() << "us";
+
+        std::int64_t limit = -1;
+
+        if (policy.spin_time != idle_policy::never_park)
+        {
+            limit = static_cast<std::int64_t>(std::min(
+                static_cast<double>(policy.spin_time.count()) *
+                    cpu_relax_iterations_per_microsecond(),
+                static_cast<double>(std::numeric_limits<std::int64_t>::max() /
+                                    4)));
+        }
+
+        idle_adaptive_.store(policy.adaptive, std::memory_order_relaxed);
+        idle_spin_limit_.store(limit, std::memory_order_relaxed);
+        idle_policy_ = policy;
+    }
+
+    idle_policy const& current_idle_policy() const { return idle_policy_; }
+
     void to_spinning_mode() { set_sleeping_mode(false); }
 
-    ~cpu_pool()
+    // In serving mode the workers (all but the owner's thread) run the
+    // tasks submitted from any thread.  Bulk synchronous executes are
+    // still allowed; serving is suspended for their duration.  That
+    // costs an execute issued in serving mode two more round trips of
+    // the dispatch barrier (leaving serving and resuming it), a futex
+    // wake when serving workers are parked, and the wait for the
+    // submitted tasks already running; executes outside serving mode
+    // are not affected.  Pools of a single worker don't serve; use
+    // run_submitted() instead.
+    // Workers that find the queue empty follow the idle policy: by
+    // default they keep spinning on it, keeping their cpus busy
+    // between submissions.
+    bool set_serving_mode(bool serve_mode)
+    {
+        bool const ret = switch_serving_mode(serve_mode);
+        drained_by_workers_.store(is_serving_ && size_ > 1);
+        return ret;
+    }
+
+    void to_serving_mode() { set_serving_mode(true); }
+
+    bool in_serving_mode() const { return is_serving_; }
+
+private:
+    // Enters or leaves serving mode, for the owner or for the duration
+    // of an execute.
+    bool switch_serving_mode(bool serve_mode)
+    {
+        enforcer_.enforce();
+
+        SYSML_STRONG_ASSERT(!async_pending_);
+
+        if (serve_mode == is_serving_)
+        {
+            return serve_mode;
+        }
+
+        if (is_serving_)
+        {
+            assert(tasks_ == serve_function_tasks_.data());
+
+            keep_serving_.store(false, std::memory_order_relaxed);
+
+            submit_epoch_.fetch_add(1);
+            if (num_serving_parked_.load() > 0)
+            {
+                detail::futex_wake_all(submit_epoch_);
+            }
+
+            // Wait for the workers to leave the serving loop.
+            dispatch_arrive_and_wait(0);
+
+            tasks_      = nullptr;
+            tasks_size_ = 0;
+
+            is_serving_ = false;
+            return true;
+        }
+        else
+        {
+            set_sleeping_mode(false);
+
+            assert(tasks_ == nullptr);
+            assert(tasks_size_ == 0);
+
+            keep_serving_.store(true, std::memory_order_relaxed);
+
+            tasks_      = serve_function_tasks_.data();
+            tasks_size_ = size_;
+
+            release_workers();
+
+            is_serving_ = true;
+            return false;
+        }
+    }
+
+public:
+    // Any thread.  Queues fn(ctx, i) for all i in [0, num_tasks) as a
+    // single batch, which the serving workers split between
+    // themselves.  The callable is copied into the batch, see
+    // submitted_batch; nothing is allocated.  Fails when the submission
+    // queue is full.
+    template <class Fn>
+    auto try_submit(Fn&& fn, std::size_t num_tasks) -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn> const&, cpu_context const&,
+                            std::size_t>,
+        bool>
+    {
+        if (num_tasks == 0)
+        {
+            return true;
+        }
+
+        if (!submitted_.try_push(
+                submitted_batch(std::forward<Fn>(fn), 0, num_tasks)))
+        {
+            return false;
+        }
+
+        notify_submitted();
+        return true;
+    }
+
+    // Any thread.  Queues a single task, fn(ctx).
+    template <class Fn>
+    auto try_submit(Fn&& task) -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn> const&, cpu_context const&>,
+        bool>
+    {
+        return try_submit(
+            [task = std::forward<Fn>(task)](cpu_context const& ctx,
+                                            std::size_t) { task(ctx); },
+            1);
+    }
+
+    // Any thread.  Like try_submit(), but yields while the submission
+    // queue is full; see submission_queue_capacity.  Throws when
+    // nobody would drain the queue.
+    template <class Fn>
+    auto submit(Fn&& fn, std::size_t num_tasks) -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn> const&, cpu_context const&,
+                            std::size_t>>
+    {
+        if (num_tasks == 0)
+        {
+            return;
+        }
+
+        submitted_batch batch(std::forward<Fn>(fn), 0, num_tasks);
+
+        // try_push only moves from the batch when it succeeds.
+        while (!submitted_.try_push(std::move(batch)))
+        {
+            if (enforcer_.is_owner())
+            {
+                run_submitted();
+                continue;
+            }
+
+            SYSML_THROW_ASSERT(drained_by_workers_.load())
+                << "Submission queue full, and the pool is not serving";
+
+            std::this_thread::yield();
+        }
+
+        notify_submitted();
+    }
+
+    template <class Fn>
+    auto submit(Fn&& task) -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn> const&, cpu_context const&>>
+    {
+        submit([task = std::forward<Fn>(task)](cpu_context const& ctx,
+                                               std::size_t) { task(ctx); },
+               1);
+    }
+
+    // Runs the submitted batches on the owner's thread, until the
+    // queue is found empty; returns the number of tasks run.
+    std::size_t run_submitted()
+    {
+        enforcer_.enforce();
+
+        std::size_t ret = 0;
+        while (auto batch = submitted_.try_pop())
+        {
+            (*batch)(zeroth_cpu_context_);
+            scratch_arenas_[0].reset();
+            ret += batch->size();
+        }
+        return ret;
+    }
+
+    ~basic_cpu_pool()
     {
         enforcer_.enforce();
 
+        // Waits for a pending execute_async, leaving its handle invalid.
+        if (async_handle_ != nullptr)
+        {
+            async_handle_->wait();
+        }
+
+        set_serving_mode(false);
+        set_sleeping_mode(false);
+
         assert(tasks_ == nullptr);
         assert(tasks_size_ == 0);
 
-        set_sleeping_mode(false);
-        spinning_barrier_.arrive_and_wait();
+        // Tasks still in the submission queue are not dropped.
+        run_submitted();
+
+        // Release the workers with no tasks set (which makes them
+        // exit), and wait for them to arrive at the final barrier.
+        release_workers();
+        dispatch_arrive_and_wait(0);
+
+        // The workers might still be spinning on the barrier; it can't
+        // be destroyed until they are done.
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
 
         // Restore main threads CPU set
         if (restore_original_cpu_set_)
@@ -292,7 +1080,7 @@ public:
     {
         enforcer_.enforce();
 
-        bool was_sleeping = set_sleeping_mode(false);
+        auto const modes = suspend_modes();
 
         assert(tasks_ == nullptr);
         assert(tasks_size_ == 0);
@@ -300,19 +1088,19 @@ public:
         tasks_      = tasks;
         tasks_size_ = tasks_size;
 
-        spinning_barrier_.arrive_and_wait();
-
-        for (std::size_t i = 0; i < tasks_size_; i += size_)
-        {
-            tasks[i](zeroth_cpu_context_);
-        }
-
-        spinning_barrier_.arrive_and_wait();
+        run_owner_share(num_range_tasks(0, tasks_size, size_),
+                        [&]()
+                        {
+                            for (std::size_t i = 0; i < tasks_size; i += size_)
+                            {
+                                tasks[i](zeroth_cpu_context_);
+                            }
+                        });
 
         tasks_      = nullptr;
         tasks_size_ = 0;
 
-        set_sleeping_mode(was_sleeping);
+        restore_modes(modes);
     }
 
     void
@@ -320,7 +1108,7 @@ public:
     {
         enforcer_.enforce();
 
-        bool was_sleeping = set_sleeping_mode(false);
+        auto const modes = suspend_modes();
 
         assert(tasks_ == nullptr);
         assert(tasks_size_ == 0);
@@ -328,30 +1116,213 @@ public:
         tasks_      = std::addressof(task);
         tasks_size_ = all_execute_the_same;
 
-        spinning_barrier_.arrive_and_wait();
-
-        task(zeroth_cpu_context_);
-
-        spinning_barrier_.arrive_and_wait();
+        run_owner_share(1, [&]() { task(zeroth_cpu_context_); });
 
         tasks_      = nullptr;
         tasks_size_ = 0;
 
-        set_sleeping_mode(was_sleeping);
+        restore_modes(modes);
+    }
+
+    // Invokes fn(ctx, i) for all i in [0, num_tasks); the worker with
+    // index w handles i = w, w + size(), ...  The callable is used by
+    // reference, the call makes no allocations.
+    template <class Fn>
+    auto execute(Fn const& fn, std::size_t num_tasks) -> std::enable_if_t<
+        std::is_invocable_v<Fn const&, cpu_context const&, std::size_t>>
+    {
+        enforcer_.enforce();
+
+        auto const modes = suspend_modes();
+
+        assert(tasks_ == nullptr);
+        assert(tasks_size_ == 0);
+        assert(range_task_ == nullptr);
+
+        range_task_         = std::addressof(fn);
+        range_task_invoker_ = &invoke_range_task<Fn>;
+        tasks_size_         = num_tasks;
+
+        run_owner_share(num_range_tasks(0, num_tasks, size_),
+                        [&]()
+                        {
+                            invoke_range_task<Fn>(range_task_,
+                                                  zeroth_cpu_context_, 0,
+                                                  num_tasks, size_);
+                        });
+
+        range_task_         = nullptr;
+        range_task_invoker_ = nullptr;
+        tasks_size_         = 0;
+
+        restore_modes(modes);
     }
 
-    // template <class Fn>
-    // auto execute_on_all_cpus(Fn&& task) -> std::enable_if<
-    //     !std::is_same_v<std::function<void(cpu_context const&)>,
-    //     std::decay_t<Fn>> && std::is_convertible_v<std::decay_t<Fn>,
-    //     std::function<void(cpu_context const&)>>>
-    // {
-    //     std::function<void(cpu_context const&)> fn = std::forward<Fn>(task);
-    //     execute_on_all_cpus(fn);
+    // Preferred over the std::function overload for lambdas and other
+    // callables, which would otherwise be converted (and possibly heap
+    // allocated) on every call.
+    template <class Fn>
+    auto execute_on_all_cpus(Fn const& task)
+        -> std::enable_if_t<std::is_invocable_v<Fn const&, cpu_context const&>>
+    {
+        execute([&task](cpu_context const& ctx, std::size_t) { task(ctx); },
+                size_);
+    }
+
+    // Handle of an execute_async call.  Waits for the completion when
+    // destroyed, unless already waited for.  The pool keeps track of
+    // the handle; destroying the pool first waits for the completion
+    // and leaves the handle invalid.
+    class execute_handle
+    {
+    private:
+        basic_cpu_pool*       pool_ = nullptr;
+        std::shared_ptr<void> task_;
 
-    //     return {};
-    // }
+        friend class basic_cpu_pool;
+
+        execute_handle(basic_cpu_pool* pool, std::shared_ptr<void> task)
+            : pool_(pool)
+            , task_(std::move(task))
+        {
+            pool_->async_handle_ = this;
+        }
 
+    public:
+        execute_handle() = default;
+
+        execute_handle(execute_handle&& other) noexcept
+            : pool_(std::exchange(other.pool_, nullptr))
+            , task_(std::move(other.task_))
+        {
+            if (pool_ != nullptr)
+            {
+                pool_->async_handle_ = this;
+            }
+        }
+
+        execute_handle& operator=(execute_handle&& other) noexcept
+        {
+            if (this != &other)
+            {
+                wait();
+                pool_ = std::exchange(other.pool_, nullptr);
+                task_ = std::move(other.task_);
+                if (pool_ != nullptr)
+                {
+                    pool_->async_handle_ = this;
+                }
+            }
+            return *this;
+        }
+
+        ~execute_handle() { wait(); }
+
+        bool valid() const noexcept { return pool_ != nullptr; }
+
+        // Whether all the tasks are done; never blocks.
+        bool test() const
+        {
+            return pool_ == nullptr || pool_->async_finished();
+        }
+
+        // Blocks until all the tasks are done.
+        void wait()
+        {
+            if (pool_ != nullptr)
+            {
+                std::exchange(pool_, nullptr)->finish_async();
+                task_.reset();
+            }
+        }
+    };
+
+    // Like execute(fn, num_tasks), but returns as soon as the workers
+    // are started; the caller's thread doesn't take part, so the
+    // worker with index w > 0 handles i = w - 1, w - 1 + (size() - 1),
+    // ...  The callable is moved to the heap and kept alive until the
+    // handle is waited for.  No other execute can be issued on the pool
+    // until then.  A pool of a single worker runs the tasks before
+    // returning.
+    template <class Fn>
+    auto execute_async(Fn&& fn, std::size_t num_tasks) -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn> const&, cpu_context const&,
+                            std::size_t>,
+        execute_handle>
+    {
+        enforcer_.enforce();
+
+        using task_type = std::decay_t<Fn>;
+
+        if (size_ == 1)
+        {
+            execute(static_cast<task_type const&>(fn), num_tasks);
+            return {};
+        }
+
+        auto task = std::make_shared<task_type>(std::forward<Fn>(fn));
+
+        SYSML_STRONG_ASSERT(!async_pending_);
+
+        async_modes_ = suspend_modes();
+
+        assert(tasks_ == nullptr);
+        assert(tasks_size_ == 0);
+        assert(range_task_ == nullptr);
+
+        range_task_         = task.get();
+        range_task_invoker_ = &invoke_range_task<task_type>;
+        tasks_size_         = num_tasks;
+        async_pending_      = true;
+        async_finished_.store(0, std::memory_order_relaxed);
+
+        release_workers();
+
+        return execute_handle(this, std::move(task));
+    }
+
+    // Runs fn(ctx) on all the workers except the caller's, see
+    // execute_async(fn, num_tasks).
+    template <class Fn>
+    auto execute_on_all_cpus_async(Fn&& task) -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn> const&, cpu_context const&>,
+        execute_handle>
+    {
+        return execute_async(
+            [task = std::forward<Fn>(task)](cpu_context const& ctx,
+                                            std::size_t) { task(ctx); },
+            size_ == 1 ? 1 : size_ - 1);
+    }
+
+private:
+    execute_handle* async_handle_ = nullptr;
+
+    bool async_finished() const
+    {
+        return async_finished_.load(std::memory_order_acquire) == size_ - 1;
+    }
+
+    void finish_async()
+    {
+        enforcer_.enforce();
+
+        SYSML_STRONG_ASSERT(async_pending_);
+
+        {
+            ns_counter barrier_wait(counters_[0].barrier_wait_ns);
+            dispatch_arrive_and_wait(0);
+        }
+
+        range_task_         = nullptr;
+        range_task_invoker_ = nullptr;
+        tasks_size_         = 0;
+        async_pending_      = false;
+        async_handle_       = nullptr;
+
+        restore_modes(async_modes_);
+    }
+
+public:
     void execute(std::function<void(cpu_context const&)> const* tasks)
     {
         execute(tasks, size_);
@@ -364,4 +1335,6 @@ public:
     }
 };
 
+using cpu_pool = basic_cpu_pool<>;
+
 } // namespace sysml::thread
@@ -0,0 +1,182 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/thread/core.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Define SYSML_THREAD_CPU_POOL_COUNTERS (or configure with
+// -DSYSML_CPU_POOL_COUNTERS=ON) to have cpu_pool record where its
+// workers spend their time.  Without it the counters compile to
+// nothing and counters() reports zeros.
+
+namespace sysml::thread
+{
+
+#if defined(SYSML_THREAD_CPU_POOL_COUNTERS)
+inline constexpr bool cpu_pool_counters_enabled = true;
+#else
+inline constexpr bool cpu_pool_counters_enabled = false;
+#endif
+
+// Snapshot of a single worker's counters.  Times are in nanoseconds.
+struct cpu_worker_counters
+{
+    std::uint64_t dispatches      = 0; // Executes taken part in
+    std::uint64_t tasks           = 0; // Tasks (or task indices) run
+    std::uint64_t busy_ns         = 0; // Running tasks
+    std::uint64_t idle_ns         = 0; // Waiting for the next execute
+    std::uint64_t barrier_wait_ns = 0; // Waiting for the others to finish
+    std::uint64_t sleeps          = 0; // Times parked in sleeping mode
+    std::uint64_t sleep_ns        = 0; // Parked in sleeping mode
+};
+
+struct cpu_pool_counters
+{
+    std::vector<cpu_worker_counters> workers;
+
+    std::uint64_t sleep_transitions = 0;
+    std::uint64_t wake_transitions  = 0;
+};
+
+namespace detail
+{
+
+using counter_type = std::atomic<std::uint64_t>;
+
+// Every counter has a single writer, its worker; relaxed loads and
+// stores are enough, and snapshots taken while the pool is running see
+// slightly stale values instead of torn ones.  Nothing else writes to
+// them, not even a reset (see basic_cpu_pool::reset_counters).
+inline void add_to_counter([[maybe_unused]] counter_type& counter,
+                           [[maybe_unused]] std::uint64_t value) noexcept
+{
+    if constexpr (cpu_pool_counters_enabled)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+    }
+}
+
+// Adds the nanoseconds elapsed during its lifetime to the counter.
+template <bool Enabled = cpu_pool_counters_enabled>
+class scoped_ns_counter
+{
+private:
+    counter_type&                         counter_;
+    std::chrono::steady_clock::time_point start_;
+
+public:
+    explicit scoped_ns_counter(counter_type& counter) noexcept
+        : counter_(counter)
+        , start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~scoped_ns_counter()
+    {
+        add_to_counter(counter_,
+                       static_cast<std::uint64_t>(
+                           std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start_)
+                               .count()));
+    }
+};
+
+template <>
+class scoped_ns_counter<false>
+{
+public:
+    explicit scoped_ns_counter(counter_type&) noexcept {}
+};
+
+struct alignas(hardware_destructive_interference_size) worker_counter_slots
+{
+    counter_type dispatches{0};
+    counter_type tasks{0};
+    counter_type busy_ns{0};
+    counter_type idle_ns{0};
+    counter_type barrier_wait_ns{0};
+    counter_type sleeps{0};
+    counter_type sleep_ns{0};
+
+    cpu_worker_counters snapshot() const noexcept
+    {
+        return {dispatches.load(std::memory_order_relaxed),
+                tasks.load(std::memory_order_relaxed),
+                busy_ns.load(std::memory_order_relaxed),
+                idle_ns.load(std::memory_order_relaxed),
+                barrier_wait_ns.load(std::memory_order_relaxed),
+                sleeps.load(std::memory_order_relaxed),
+                sleep_ns.load(std::memory_order_relaxed)};
+    }
+
+};
+
+// The counts accumulated since the earlier snapshot was taken.
+inline cpu_worker_counters counted_since(cpu_worker_counters const& now,
+                                         cpu_worker_counters const& then)
+{
+    return {now.dispatches - then.dispatches,
+            now.tasks - then.tasks,
+            now.busy_ns - then.busy_ns,
+            now.idle_ns - then.idle_ns,
+            now.barrier_wait_ns - then.barrier_wait_ns,
+            now.sleeps - then.sleeps,
+            now.sleep_ns - then.sleep_ns};
+}
+
+// The slots of all the workers of a pool.
+template <bool Enabled = cpu_pool_counters_enabled>
+class worker_counter_array
+{
+private:
+    std::unique_ptr<worker_counter_slots[]> slots_;
+
+public:
+    explicit worker_counter_array(std::size_t size)
+        : slots_(std::make_unique<worker_counter_slots[]>(size))
+    {
+    }
+
+    worker_counter_slots& operator[](std::size_t i) noexcept
+    {
+        return slots_[i];
+    }
+
+    worker_counter_slots const& operator[](std::size_t i) const noexcept
+    {
+        return slots_[i];
+    }
+};
+
+// With the counters compiled out nothing is allocated; every worker
+// gets the same slots, which are never written to.
+template <>
+class worker_counter_array<false>
+{
+private:
+    inline static worker_counter_slots unused_;
+
+public:
+    explicit worker_counter_array(std::size_t) noexcept {}
+
+    worker_counter_slots& operator[](std::size_t) noexcept { return unused_; }
+
+    worker_counter_slots const& operator[](std::size_t) const noexcept
+    {
+        return unused_;
+    }
+};
+
+} // namespace detail
+} // namespace sysml::thread
@@ -11,76 +11,254 @@
 
 #if !defined(__APPLE__)
 
+#    include <algorithm>
+#    include <cerrno>
+#    include <cstdlib>
+#    include <cstring>
+#    include <fstream>
 #    include <memory>
 #    include <sched.h>
+#    include <string>
+#    include <unistd.h>
+#    include <utility>
 
 namespace sysml::thread
 {
 
+namespace detail
+{
+
+// Number of cpus a mask needs to hold to cover every cpu the system
+// could bring online (at least CPU_SETSIZE).
+inline int possible_cpus()
+{
+    static int const ret = []()
+    {
+        long n = std::max<long>(CPU_SETSIZE, sysconf(_SC_NPROCESSORS_CONF));
+
+        // E.g. "0-1535" or "0-63,128-191"; the last number is the
+        // highest cpu id.
+        std::ifstream in("/sys/devices/system/cpu/possible");
+        std::string   list;
+        if (in >> list)
+        {
+            auto pos  = list.find_last_of(",-");
+            auto last = std::strtol(
+                list.c_str() + (pos == std::string::npos ? 0 : pos + 1),
+                nullptr, 10);
+            n = std::max(n, last + 1);
+        }
+
+        return static_cast<int>(n);
+    }();
+
+    return ret;
+}
+
+struct cpu_set_deleter
+{
+    void operator()(cpu_set_t* p) const noexcept { CPU_FREE(p); }
+};
+
+} // namespace detail
+
+// Dynamically sized cpu mask (CPU_ALLOC), large enough for all the
+// possible cpus of the system by default; setting a cpu beyond the
+// current capacity grows the mask.  A moved from set has no mask; it
+// is empty, and gets a mask again when needed.
 class cpu_set
 {
 public:
     using native_handle_type = cpu_set_t;
 
 private:
-    std::unique_ptr<native_handle_type> handle;
+    using handle_type =
+        std::unique_ptr<native_handle_type, detail::cpu_set_deleter>;
+
+    std::size_t size_ = 0;
+    handle_type handle;
+
+    void allocate(int num_cpus)
+    {
+        handle.reset(CPU_ALLOC(num_cpus));
+        SYSML_STRONG_ASSERT(handle != nullptr);
+        size_ = CPU_ALLOC_SIZE(num_cpus);
+        CPU_ZERO_S(size_, handle.get());
+    }
+
+    void grow(int num_cpus)
+    {
+        cpu_set bigger(std::max(num_cpus, 2 * capacity()));
+        if (handle)
+        {
+            std::memcpy(bigger.handle.get(), handle.get(), size_);
+        }
+        *this = std::move(bigger);
+    }
 
 public:
-    cpu_set()
-        : handle(std::make_unique<native_handle_type>())
+    cpu_set() { allocate(detail::possible_cpus()); }
+
+    // Room for at least num_cpus cpus.
+    explicit cpu_set(int num_cpus)
     {
-        CPU_ZERO(handle.get());
+        SYSML_STRONG_ASSERT(num_cpus > 0);
+        allocate(num_cpus);
     }
 
     cpu_set& operator=(cpu_set const& other)
     {
         if (this != &other)
         {
-            CPU_ZERO(handle.get());
-            CPU_OR(handle.get(), handle.get(), other.handle.get());
+            if (!other.handle)
+            {
+                handle.reset();
+                size_ = 0;
+            }
+            else
+            {
+                if (size_ != other.size_)
+                {
+                    allocate(other.capacity());
+                }
+                std::memcpy(handle.get(), other.handle.get(), size_);
+            }
         }
         return *this;
     }
 
     cpu_set(cpu_set const& other) { *this = other; }
 
-    cpu_set& operator=(cpu_set&&) = default;
-    cpu_set(cpu_set&&)            = default;
+    cpu_set& operator=(cpu_set&& other) noexcept
+    {
+        if (this != &other)
+        {
+            size_  = std::exchange(other.size_, 0);
+            handle = std::move(other.handle);
+        }
+        return *this;
+    }
 
-    native_handle_type&       native_handle() { return *handle; }
-    native_handle_type const& native_handle() const { return *handle; }
+    cpu_set(cpu_set&& other) noexcept
+        : size_(std::exchange(other.size_, 0))
+        , handle(std::move(other.handle))
+    {
+    }
+
+    // Allocates the default mask of a moved from set.
+    native_handle_type& native_handle()
+    {
+        if (!handle)
+        {
+            allocate(detail::possible_cpus());
+        }
+        return *handle;
+    }
+
+    // An empty mask for a moved from set, of native_size() 0.
+    native_handle_type const& native_handle() const
+    {
+        static native_handle_type const empty{};
+        return handle ? *handle : empty;
+    }
+
+    // Size of the native mask in bytes, as sched_{get,set}affinity
+    // expect it.
+    std::size_t native_size() const noexcept { return size_; }
+
+    // Number of cpus the mask can currently hold; at least that many,
+    // as CPU_ALLOC rounds up.
+    int capacity() const noexcept { return static_cast<int>(size_ * 8); }
+
+    void reserve(int num_cpus)
+    {
+        if (num_cpus > capacity())
+        {
+            grow(num_cpus);
+        }
+    }
 
 public:
-    void clear_all() { CPU_ZERO(handle.get()); }
+    void clear_all() { zero(); }
 
-    void zero() { CPU_ZERO(handle.get()); }
+    void zero()
+    {
+        if (handle)
+        {
+            CPU_ZERO_S(size_, handle.get());
+        }
+    }
 
-    void set(int cpu) { CPU_SET(cpu, handle.get()); }
+    void set(int cpu)
+    {
+        reserve(cpu + 1);
+        CPU_SET_S(cpu, size_, handle.get());
+    }
 
-    void clr(int cpu) { CPU_CLR(cpu, handle.get()); }
+    void clr(int cpu)
+    {
+        if (cpu < capacity())
+        {
+            CPU_CLR_S(cpu, size_, handle.get());
+        }
+    }
 
-    bool is_set(int cpu) const { return CPU_ISSET(cpu, handle.get()); }
+    bool is_set(int cpu) const
+    {
+        return cpu < capacity() && CPU_ISSET_S(cpu, size_, handle.get());
+    }
 
-    int count() const { return CPU_COUNT(handle.get()); }
+    int count() const { return handle ? CPU_COUNT_S(size_, handle.get()) : 0; }
 
     friend bool operator==(cpu_set const& lhs, cpu_set const& rhs)
     {
-        return CPU_EQUAL(lhs.handle.get(), rhs.handle.get());
+        if (lhs.size_ == rhs.size_)
+        {
+            if (lhs.size_ == 0) // Both moved from
+            {
+                return true;
+            }
+            return CPU_EQUAL_S(lhs.size_, lhs.handle.get(), rhs.handle.get());
+        }
+
+        auto const& larger = lhs.size_ > rhs.size_ ? lhs : rhs;
+        auto const& other  = lhs.size_ > rhs.size_ ? rhs : lhs;
+
+        if (larger.count() != other.count())
+        {
+            return false;
+        }
+
+        for (int cpu = 0; cpu < other.capacity(); ++cpu)
+        {
+            if (larger.is_set(cpu) != other.is_set(cpu))
+            {
+                return false;
+            }
+        }
+
+        return true;
     }
 };
 
+// Grows the mask when the kernel supports more cpus than it holds.
 inline void get_affinity(cpu_set& set)
 {
-    SYSML_STRONG_ASSERT(
-        sched_getaffinity(0, sizeof(cpu_set::native_handle_type),
-                          std::addressof(set.native_handle())) == 0);
+    set.reserve(1); // A moved from set has no mask
+
+    while (sched_getaffinity(0, set.native_size(),
+                             std::addressof(set.native_handle())) != 0)
+    {
+        SYSML_STRONG_ASSERT(errno == EINVAL && set.capacity() < (1 << 24));
+        set.reserve(2 * set.capacity());
+    }
 }
 
 inline void set_affinity(cpu_set const& set)
 {
-    SYSML_STRONG_ASSERT(
-        sched_setaffinity(0, sizeof(cpu_set::native_handle_type),
-                          std::addressof(set.native_handle())) == 0);
+    SYSML_STRONG_ASSERT(sched_setaffinity(0, set.native_size(),
+                                          std::addressof(
+                                              set.native_handle())) == 0);
 }
 
 inline void bind_to_core(int core)
@@ -0,0 +1,138 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/assert.hpp"
+#include "sysml/thread/core.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace sysml::thread
+{
+
+// Bounded multi-producer multi-consumer queue (D. Vyukov's array based
+// design).  Every cell carries a sequence number telling whether it is
+// ready to be written or read in the current lap, so producers and
+// consumers only contend on their own position counter.  Neither
+// push nor pop ever blocks; they fail when the queue is full or empty.
+template <class T>
+class mpmc_queue
+{
+private:
+    struct cell
+    {
+        std::atomic<std::size_t> sequence;
+        T                        value;
+    };
+
+    std::size_t const       mask_;
+    std::unique_ptr<cell[]> cells_;
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::size_t> enqueue_pos_{0};
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::size_t> dequeue_pos_{0};
+
+public:
+    // capacity has to be a power of two.
+    explicit mpmc_queue(std::size_t capacity)
+        : mask_(capacity - 1)
+        , cells_(std::make_unique<cell[]>(capacity))
+    {
+        SYSML_STRONG_ASSERT(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+
+        for (std::size_t i = 0; i < capacity; ++i)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpmc_queue(mpmc_queue const&)            = delete;
+    mpmc_queue& operator=(mpmc_queue const&) = delete;
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    template <class U>
+    bool try_push(U&& value)
+    {
+        auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            auto& c   = cells_[pos & mask_];
+            auto  seq = c.sequence.load(std::memory_order_acquire);
+            auto  dif = static_cast<std::ptrdiff_t>(seq) -
+                       static_cast<std::ptrdiff_t>(pos);
+
+            if (dif == 0)
+            {
+                if (enqueue_pos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    c.value = std::forward<U>(value);
+                    c.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0) // Full
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::optional<T> try_pop()
+    {
+        auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            auto& c   = cells_[pos & mask_];
+            auto  seq = c.sequence.load(std::memory_order_acquire);
+            auto  dif = static_cast<std::ptrdiff_t>(seq) -
+                       static_cast<std::ptrdiff_t>(pos + 1);
+
+            if (dif == 0)
+            {
+                if (dequeue_pos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    std::optional<T> ret(std::move(c.value));
+                    c.value = T();
+                    c.sequence.store(pos + mask_ + 1,
+                                     std::memory_order_release);
+                    return ret;
+                }
+            }
+            else if (dif < 0) // Empty
+            {
+                return std::nullopt;
+            }
+            else
+            {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Only a snapshot when other threads are pushing or popping.
+    bool empty() const noexcept
+    {
+        return dequeue_pos_.load(std::memory_order_relaxed) >=
+               enqueue_pos_.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace sysml::thread
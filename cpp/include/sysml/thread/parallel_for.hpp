@@ -10,46 +10,74 @@
 #include "sysml/sysml.hpp"
 #include "sysml/thread/cpu_pool.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <optional>
 #include <type_traits>
 #include <vector>
 
 namespace sysml::thread
 {
 
+namespace detail
+{
+
 template <class Int, class Fn>
-inline auto naive_parallel_for(cpu_pool& working_cpu_pool, Int from,
-                               std::type_identity_t<Int> to,
+__attribute__((always_inline)) inline decltype(auto)
+invoke_loop_body(Fn& fn, [[maybe_unused]] cpu_context const& ctx, Int idx)
+{
+    if constexpr (std::is_invocable_v<std::decay_t<Fn>, Int>)
+    {
+        return fn(idx);
+    }
+    else
+    {
+        return fn(ctx, idx);
+    }
+}
+
+template <class Int, class Fn>
+__attribute__((always_inline)) inline void
+run_iterations(Fn& fn, cpu_context const& ctx, Int from, Int stride,
+               std::int64_t first, std::int64_t last)
+{
+    for (auto k = first; k < last; ++k)
+    {
+        Int const idx = from + static_cast<Int>(k) * stride;
+        invoke_loop_body<Int>(fn, ctx, idx);
+    }
+}
+
+} // namespace detail
+
+template <class Int, class Fn, class Barrier>
+inline auto naive_parallel_for(basic_cpu_pool<Barrier>& working_cpu_pool,
+                               Int from, std::type_identity_t<Int> to,
                                std::type_identity_t<Int> stride, Fn&& fn)
     -> std::enable_if_t<
         std::is_invocable_v<std::decay_t<Fn>, Int> ||
         std::is_invocable_v<std::decay_t<Fn>, cpu_context const&, Int>>
 {
-    std::vector<std::function<void(cpu_context const&)>> tasks(
-        num_iterations(from, to, stride));
-
-    for (auto i = from; i < to; i += stride)
+    if (!(from < to))
     {
-        tasks[i] = [&fn, i]([[maybe_unused]] cpu_context const& ctx)
-        {
-            if constexpr (std::is_invocable_v<std::decay_t<Fn>, Int>)
-            {
-                fn(i);
-            }
-            else
-            {
-                fn(ctx, i);
-            }
-        };
+        return;
     }
 
-    working_cpu_pool.execute(tasks);
+    auto task = [&fn, from, stride](cpu_context const& ctx, std::size_t k)
+    {
+        Int const idx = from + static_cast<Int>(k) * stride;
+        detail::invoke_loop_body<Int>(fn, ctx, idx);
+    };
+
+    working_cpu_pool.execute(
+        task, static_cast<std::size_t>(num_iterations(from, to, stride)));
 }
 
-template <class Int, class Fn>
-inline auto single_queue_parallel_for(cpu_pool& working_cpu_pool, Int from,
-                                      std::type_identity_t<Int> to,
+template <class Int, class Fn, class Barrier>
+inline auto single_queue_parallel_for(basic_cpu_pool<Barrier>& working_cpu_pool,
+                                      Int from, std::type_identity_t<Int> to,
                                       std::type_identity_t<Int> stride, Fn&& fn)
     -> std::enable_if_t<
         std::is_invocable_v<std::decay_t<Fn>, Int> ||
@@ -77,4 +105,422 @@ inline auto single_queue_parallel_for(cpu_pool& working_cpu_pool, Int from,
     working_cpu_pool.execute_on_all_cpus(task);
 }
 
+// Recursive splitting with work stealing.  Each worker starts with a
+// contiguous block of the iteration space in its own deque.  Ranges
+// are split in halves until they are no larger than grain_size; the
+// upper halves are pushed to the worker's deque and can be stolen by
+// the workers that ran out of work.
+template <class Int, class Fn, class Barrier>
+inline auto parallel_for_dynamic(basic_cpu_pool<Barrier>& working_cpu_pool,
+                                 Int from, std::type_identity_t<Int> to,
+                                 std::type_identity_t<Int> stride, Fn&& fn,
+                                 std::type_identity_t<Int> grain_size = 1)
+    -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn>, Int> ||
+        std::is_invocable_v<std::decay_t<Fn>, cpu_context const&, Int>>
+{
+    if (!(from < to))
+    {
+        return;
+    }
+
+    std::int64_t const total =
+        static_cast<std::int64_t>(num_iterations(from, to, stride));
+    std::int64_t const grain =
+        std::max(static_cast<std::int64_t>(grain_size), std::int64_t(1));
+    std::int64_t const num_workers =
+        static_cast<std::int64_t>(working_cpu_pool.size());
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::int64_t> remaining{total};
+
+    auto task = [&](cpu_context const& ctx)
+    {
+        auto& own = working_cpu_pool.local_deque(ctx.cpu_index);
+
+        {
+            auto const idx   = static_cast<std::int64_t>(ctx.cpu_index);
+            auto const first = total * idx / num_workers;
+            auto const last  = total * (idx + 1) / num_workers;
+
+            if (first < last)
+            {
+                own.push({first, last});
+            }
+        }
+
+        while (remaining.load(std::memory_order_relaxed) > 0)
+        {
+            auto range = own.pop();
+
+            for (std::int64_t i = 1; !range && i < num_workers; ++i)
+            {
+                auto victim = (static_cast<std::int64_t>(ctx.cpu_index) + i) %
+                              num_workers;
+                range = working_cpu_pool.local_deque(victim).steal();
+            }
+
+            if (!range)
+            {
+                DABUN_THREAD_CPU_RELAX();
+                continue;
+            }
+
+            while (range->size() > grain)
+            {
+                auto mid = range->begin + range->size() / 2;
+                if (!own.push({mid, range->end}))
+                {
+                    break;
+                }
+                range->end = mid;
+            }
+
+            detail::run_iterations<Int>(fn, ctx, from, stride, range->begin,
+                                        range->end);
+
+            remaining.fetch_sub(range->size(), std::memory_order_relaxed);
+        }
+    };
+
+    working_cpu_pool.execute_on_all_cpus(task);
+}
+
+// Scheduling policies for parallel_for.
+
+// Each worker gets one contiguous block of (roughly) equal size.
+struct static_block_schedule
+{
+};
+
+// Workers grab chunks of chunk_size iterations from a shared counter.
+struct chunked_schedule
+{
+    std::size_t chunk_size = 1;
+};
+
+// Workers grab chunks proportional to the remaining work divided by
+// twice the number of workers, but no smaller than min_chunk_size.
+struct guided_schedule
+{
+    std::size_t min_chunk_size = 1;
+};
+
+// Recursive splitting with work stealing, see parallel_for_dynamic.
+struct dynamic_schedule
+{
+    std::size_t grain_size = 1;
+};
+
+// Remembers which worker ran which chunk of a loop, so that repeated
+// parallel_for calls over the same range hand every worker the chunks
+// it ran the last time, whose data is likely still in its caches.
+// Workers that are done with their own chunks steal from the others,
+// starting at the far end of their lists; a stolen chunk stays with
+// the thief in the following calls.  The first call (and every call
+// with a different number of iterations or workers) starts with
+// contiguous blocks, as static_block_schedule.
+//
+// A handle can't be used by two loops running at the same time.
+class loop_affinity
+{
+public:
+    static constexpr std::size_t default_chunks_per_worker = 8;
+
+private:
+    std::size_t  chunks_per_worker_;
+    std::int64_t total_       = -1;
+    std::size_t  num_workers_ = 0;
+
+    std::vector<std::size_t>       owner_;   // Who ran each chunk
+    std::vector<std::int64_t>      order_;   // Chunks grouped by owner
+    std::vector<std::int64_t>      offsets_; // Of the groups in order_
+    std::vector<std::atomic<bool>> claimed_;
+
+    void group_by_owner()
+    {
+        offsets_.assign(num_workers_ + 1, 0);
+        for (auto w : owner_)
+        {
+            ++offsets_[w + 1];
+        }
+        for (std::size_t w = 0; w < num_workers_; ++w)
+        {
+            offsets_[w + 1] += offsets_[w];
+        }
+
+        auto next = offsets_;
+        for (std::size_t c = 0; c < owner_.size(); ++c)
+        {
+            order_[next[owner_[c]]++] = static_cast<std::int64_t>(c);
+        }
+    }
+
+    template <class Body>
+    bool try_run(std::int64_t c, std::size_t worker, Body& body)
+    {
+        if (claimed_[c].load(std::memory_order_relaxed) ||
+            claimed_[c].exchange(true, std::memory_order_relaxed))
+        {
+            return false;
+        }
+
+        body(first(c), last(c));
+        owner_[c] = worker;
+        return true;
+    }
+
+public:
+    explicit loop_affinity(
+        std::size_t chunks_per_worker = default_chunks_per_worker)
+        : chunks_per_worker_(std::max(chunks_per_worker, std::size_t(1)))
+    {
+    }
+
+    loop_affinity(loop_affinity const&)            = delete;
+    loop_affinity& operator=(loop_affinity const&) = delete;
+
+    std::size_t num_chunks() const noexcept { return owner_.size(); }
+
+    std::int64_t first(std::int64_t c) const noexcept
+    {
+        return total_ * c / static_cast<std::int64_t>(owner_.size());
+    }
+
+    std::int64_t last(std::int64_t c) const noexcept
+    {
+        return total_ * (c + 1) / static_cast<std::int64_t>(owner_.size());
+    }
+
+    // The worker that ran chunk c in the last call.
+    std::size_t owner(std::size_t c) const { return owner_.at(c); }
+
+    // The remaining members are used by parallel_for.
+
+    // Called before the workers start.
+    void prepare(std::int64_t total, std::size_t num_workers)
+    {
+        if (total != total_ || num_workers != num_workers_)
+        {
+            total_       = total;
+            num_workers_ = num_workers;
+
+            auto const n = static_cast<std::size_t>(std::min(
+                total, static_cast<std::int64_t>(num_workers *
+                                                 chunks_per_worker_)));
+
+            owner_.resize(n);
+            for (std::size_t c = 0; c < n; ++c)
+            {
+                owner_[c] = c * num_workers / n;
+            }
+
+            order_.resize(n);
+            claimed_ = std::vector<std::atomic<bool>>(n);
+
+            group_by_owner();
+        }
+
+        for (auto& c : claimed_)
+        {
+            c.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Runs body(first, last) for the worker's own chunks, then for the
+    // chunks it can steal from the others.
+    template <class Body>
+    void run(std::size_t worker, Body&& body)
+    {
+        for (auto k = offsets_[worker]; k < offsets_[worker + 1]; ++k)
+        {
+            try_run(order_[k], worker, body);
+        }
+
+        for (std::size_t i = 1; i < num_workers_; ++i)
+        {
+            auto const victim = (worker + i) % num_workers_;
+            for (auto k = offsets_[victim + 1]; k-- > offsets_[victim];)
+            {
+                try_run(order_[k], worker, body);
+            }
+        }
+    }
+
+    // Called after all the workers are done.
+    void finish() { group_by_owner(); }
+};
+
+// Chunks go to the workers that ran them in the previous call with the
+// same handle, see loop_affinity.  Without a handle, nothing is
+// remembered from one call to the next.
+struct affinity_schedule
+{
+    loop_affinity* affinity = nullptr;
+};
+
+template <class Int, class Fn, class Barrier>
+inline auto parallel_for(basic_cpu_pool<Barrier>& working_cpu_pool,
+                         Int from, std::type_identity_t<Int> to,
+                         std::type_identity_t<Int> stride, Fn&& fn,
+                         static_block_schedule)
+    -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn>, Int> ||
+        std::is_invocable_v<std::decay_t<Fn>, cpu_context const&, Int>>
+{
+    if (!(from < to))
+    {
+        return;
+    }
+
+    std::int64_t const total =
+        static_cast<std::int64_t>(num_iterations(from, to, stride));
+    std::int64_t const num_workers =
+        static_cast<std::int64_t>(working_cpu_pool.size());
+
+    auto task = [&](cpu_context const& ctx)
+    {
+        auto const idx = static_cast<std::int64_t>(ctx.cpu_index);
+        detail::run_iterations<Int>(fn, ctx, from, stride,
+                                    total * idx / num_workers,
+                                    total * (idx + 1) / num_workers);
+    };
+
+    working_cpu_pool.execute_on_all_cpus(task);
+}
+
+template <class Int, class Fn, class Barrier>
+inline auto parallel_for(basic_cpu_pool<Barrier>& working_cpu_pool,
+                         Int from, std::type_identity_t<Int> to,
+                         std::type_identity_t<Int> stride, Fn&& fn,
+                         chunked_schedule schedule)
+    -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn>, Int> ||
+        std::is_invocable_v<std::decay_t<Fn>, cpu_context const&, Int>>
+{
+    if (!(from < to))
+    {
+        return;
+    }
+
+    std::int64_t const total =
+        static_cast<std::int64_t>(num_iterations(from, to, stride));
+    std::int64_t const chunk = std::max(
+        static_cast<std::int64_t>(schedule.chunk_size), std::int64_t(1));
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::int64_t> next{0};
+
+    auto task = [&](cpu_context const& ctx)
+    {
+        for (auto first = next.fetch_add(chunk, std::memory_order_relaxed);
+             first < total;
+             first = next.fetch_add(chunk, std::memory_order_relaxed))
+        {
+            detail::run_iterations<Int>(fn, ctx, from, stride, first,
+                                        std::min(first + chunk, total));
+        }
+    };
+
+    working_cpu_pool.execute_on_all_cpus(task);
+}
+
+template <class Int, class Fn, class Barrier>
+inline auto parallel_for(basic_cpu_pool<Barrier>& working_cpu_pool,
+                         Int from, std::type_identity_t<Int> to,
+                         std::type_identity_t<Int> stride, Fn&& fn,
+                         guided_schedule schedule)
+    -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn>, Int> ||
+        std::is_invocable_v<std::decay_t<Fn>, cpu_context const&, Int>>
+{
+    if (!(from < to))
+    {
+        return;
+    }
+
+    std::int64_t const total =
+        static_cast<std::int64_t>(num_iterations(from, to, stride));
+    std::int64_t const min_chunk = std::max(
+        static_cast<std::int64_t>(schedule.min_chunk_size), std::int64_t(1));
+    std::int64_t const divisor =
+        2 * static_cast<std::int64_t>(working_cpu_pool.size());
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::int64_t> next{0};
+
+    auto task = [&](cpu_context const& ctx)
+    {
+        auto first = next.load(std::memory_order_relaxed);
+
+        while (first < total)
+        {
+            auto chunk =
+                std::min(std::max((total - first) / divisor, min_chunk),
+                         total - first);
+
+            if (next.compare_exchange_weak(first, first + chunk,
+                                           std::memory_order_relaxed))
+            {
+                detail::run_iterations<Int>(fn, ctx, from, stride, first,
+                                            first + chunk);
+                first = next.load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    working_cpu_pool.execute_on_all_cpus(task);
+}
+
+template <class Int, class Fn, class Barrier>
+inline auto parallel_for(basic_cpu_pool<Barrier>& working_cpu_pool,
+                         Int from, std::type_identity_t<Int> to,
+                         std::type_identity_t<Int> stride, Fn&& fn,
+                         dynamic_schedule schedule)
+    -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn>, Int> ||
+        std::is_invocable_v<std::decay_t<Fn>, cpu_context const&, Int>>
+{
+    parallel_for_dynamic(working_cpu_pool, from, to, stride,
+                         std::forward<Fn>(fn),
+                         static_cast<Int>(schedule.grain_size));
+}
+
+template <class Int, class Fn, class Barrier>
+inline auto parallel_for(basic_cpu_pool<Barrier>& working_cpu_pool,
+                         Int from, std::type_identity_t<Int> to,
+                         std::type_identity_t<Int> stride, Fn&& fn,
+                         affinity_schedule schedule)
+    -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn>, Int> ||
+        std::is_invocable_v<std::decay_t<Fn>, cpu_context const&, Int>>
+{
+    if (!(from < to))
+    {
+        return;
+    }
+
+    std::optional<loop_affinity> one_off;
+    loop_affinity&               affinity =
+        schedule.affinity ? *schedule.affinity : one_off.emplace();
+
+    affinity.prepare(
+        static_cast<std::int64_t>(num_iterations(from, to, stride)),
+        working_cpu_pool.size());
+
+    auto task = [&](cpu_context const& ctx)
+    {
+        affinity.run(ctx.cpu_index,
+                     [&](std::int64_t first, std::int64_t last)
+                     {
+                         detail::run_iterations<Int>(fn, ctx, from, stride,
+                                                     first, last);
+                     });
+    };
+
+    working_cpu_pool.execute_on_all_cpus(task);
+
+    affinity.finish();
+}
+
 } // namespace sysml::thread
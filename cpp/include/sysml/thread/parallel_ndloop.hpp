@@ -0,0 +1,137 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/assert.hpp"
+#include "sysml/ndloop.hpp"
+#include "sysml/thread/cpu_pool.hpp"
+#include "sysml/thread/parallel_for.hpp"
+#include "sysml/vek.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace sysml::thread
+{
+
+namespace detail
+{
+
+// The box [begin, end) cut into tiles of the given extents (smaller at
+// the upper boundaries).  Tiles are numbered in row-major order, so
+// consecutive tile numbers are neighbours along the last dimension.
+template <class Int, std::size_t N>
+class nd_tiling
+{
+private:
+    vek<Int, N>                 begin_;
+    vek<Int, N>                 end_;
+    vek<Int, N>                 tile_;
+    std::array<std::int64_t, N> counts_;
+    std::int64_t                total_ = 1;
+
+public:
+    nd_tiling(vek<Int, N> const& begin, vek<Int, N> const& end,
+              vek<Int, N> const& tile)
+        : begin_(begin)
+        , end_(end)
+        , tile_(tile)
+    {
+        for (std::size_t d = 0; d < N; ++d)
+        {
+            SYSML_THROW_ASSERT(tile_[d] > 0)
+                << "Tile extent " << tile_[d] << " in dimension " << d;
+
+            auto const extent = static_cast<std::int64_t>(end_[d]) -
+                                static_cast<std::int64_t>(begin_[d]);
+            auto const t      = static_cast<std::int64_t>(tile_[d]);
+
+            counts_[d] = extent > 0 ? (extent + t - 1) / t : 0;
+            total_ *= counts_[d];
+        }
+    }
+
+    std::int64_t size() const noexcept { return total_; }
+
+    void bounds(std::int64_t t, vek<Int, N>& first, vek<Int, N>& last) const
+    {
+        for (std::size_t d = N; d-- > 0;)
+        {
+            auto const c = t % counts_[d];
+            t /= counts_[d];
+
+            first[d] = begin_[d] + static_cast<Int>(c) * tile_[d];
+            last[d]  = std::min(end_[d], static_cast<Int>(first[d] + tile_[d]));
+        }
+    }
+};
+
+} // namespace detail
+
+// Cuts the box [begin, end) into tiles and spreads them across the
+// workers of the pool with the given parallel_for schedule.  fn is
+// called once per tile, as fn(tile_begin, tile_end) or
+// fn(ctx, tile_begin, tile_end).
+template <class Fn, class Int, std::size_t N, class Barrier,
+          class Schedule = static_block_schedule>
+inline auto parallel_ndloop_tiles(basic_cpu_pool<Barrier>& working_cpu_pool,
+                                  vek<Int, N> const&       begin,
+                                  vek<Int, N> const&       end,
+                                  vek<Int, N> const& tile, Fn&& fn,
+                                  Schedule schedule = {})
+    -> std::enable_if_t<
+        std::is_invocable_v<std::decay_t<Fn>, vek<Int, N> const&,
+                            vek<Int, N> const&> ||
+        std::is_invocable_v<std::decay_t<Fn>, cpu_context const&,
+                            vek<Int, N> const&, vek<Int, N> const&>>
+{
+    detail::nd_tiling<Int, N> const tiling(begin, end, tile);
+
+    auto body = [&](cpu_context const& ctx, std::int64_t t)
+    {
+        vek<Int, N> first;
+        vek<Int, N> last;
+        tiling.bounds(t, first, last);
+
+        if constexpr (std::is_invocable_v<std::decay_t<Fn>, vek<Int, N> const&,
+                                          vek<Int, N> const&>)
+        {
+            fn(first, last);
+        }
+        else
+        {
+            fn(ctx, first, last);
+        }
+    };
+
+    parallel_for(working_cpu_pool, std::int64_t(0), tiling.size(), 1, body,
+                 schedule);
+}
+
+// Like parallel_ndloop_tiles, but calls fn for every point of the box,
+// as ndloop does (fn(v) or fn(i, j, ...)).  Each worker visits the
+// points of its tiles one tile at a time.
+template <class Fn, class Int, std::size_t N, class Barrier,
+          class Schedule = static_block_schedule>
+inline auto parallel_ndloop(basic_cpu_pool<Barrier>& working_cpu_pool,
+                            vek<Int, N> const& begin, vek<Int, N> const& end,
+                            vek<Int, N> const& tile, Fn const& fn,
+                            Schedule schedule = {})
+    -> std::enable_if_t<
+        std::is_invocable_v<Fn const&, vek<Int, N> const&> ||
+        ndloop_detail::is_exploded_invokable_v<Fn, vek<Int, N>>>
+{
+    parallel_ndloop_tiles(
+        working_cpu_pool, begin, end, tile,
+        [&fn](vek<Int, N> const& first, vek<Int, N> const& last)
+        { ndloop(first, last, fn); },
+        schedule);
+}
+
+} // namespace sysml::thread
@@ -0,0 +1,289 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/math.hpp"
+#include "sysml/thread/cpu_pool.hpp"
+#include "sysml/thread/parallel_for.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace sysml::thread
+{
+
+// Combine policies for parallel_reduce and the parallel scans.
+
+// One partial per worker (a contiguous block of the iterations each),
+// combined in worker order.  Results are reproducible for a given
+// number of workers.
+struct per_worker_combine
+{
+};
+
+// One partial per block of block_size iterations, combined in block
+// order.  The blocks don't depend on the number of workers, so the
+// results are bit-identical across runs and thread counts.
+struct deterministic_combine
+{
+    std::size_t block_size = 4096;
+};
+
+namespace detail
+{
+
+template <class T>
+struct alignas(hardware_destructive_interference_size) padded_partial
+{
+    T value;
+};
+
+// The blocks of [0, total) for the combine policy, and who runs them.
+class combine_blocks
+{
+private:
+    std::int64_t total_;
+    std::int64_t num_blocks_;
+    std::int64_t block_size_; // Zero for the per worker blocks
+
+public:
+    combine_blocks(std::int64_t total, std::size_t num_workers,
+                   per_worker_combine)
+        : total_(total)
+        , num_blocks_(static_cast<std::int64_t>(num_workers))
+        , block_size_(0)
+    {
+    }
+
+    combine_blocks(std::int64_t total, std::size_t,
+                   deterministic_combine policy)
+        : total_(total)
+        , block_size_(std::max(static_cast<std::int64_t>(policy.block_size),
+                               std::int64_t(1)))
+    {
+        num_blocks_ = (total_ + block_size_ - 1) / block_size_;
+    }
+
+    std::int64_t size() const noexcept { return num_blocks_; }
+
+    std::int64_t first(std::int64_t b) const noexcept
+    {
+        return block_size_ ? b * block_size_ : total_ * b / num_blocks_;
+    }
+
+    std::int64_t last(std::int64_t b) const noexcept
+    {
+        return block_size_ ? std::min(total_, (b + 1) * block_size_)
+                           : total_ * (b + 1) / num_blocks_;
+    }
+
+    // Calls fn(ctx, b) for every block; the per worker blocks go to
+    // their workers, the fixed size ones are grabbed from a shared
+    // counter.
+    template <class Barrier, class Fn>
+    void for_each(basic_cpu_pool<Barrier>& pool, Fn const& fn) const
+    {
+        if (block_size_ == 0)
+        {
+            pool.execute_on_all_cpus(
+                [&](cpu_context const& ctx)
+                { fn(ctx, static_cast<std::int64_t>(ctx.cpu_index)); });
+            return;
+        }
+
+        alignas(hardware_destructive_interference_size)
+            std::atomic<std::int64_t> next{0};
+
+        pool.execute_on_all_cpus(
+            [&](cpu_context const& ctx)
+            {
+                for (auto b = next.fetch_add(1, std::memory_order_relaxed);
+                     b < num_blocks_;
+                     b = next.fetch_add(1, std::memory_order_relaxed))
+                {
+                    fn(ctx, b);
+                }
+            });
+    }
+};
+
+} // namespace detail
+
+// Returns combine(...combine(identity, fn(i0))..., fn(in)) over the
+// iterations of [from, to) with the given stride, where fn is called
+// as fn(i) or fn(ctx, i).  combine has to be associative; identity is
+// the starting value of every partial.
+template <class T, class Int, class Fn, class Combine, class Barrier,
+          class Policy = per_worker_combine>
+inline auto parallel_reduce(basic_cpu_pool<Barrier>& working_cpu_pool,
+                            Int from, std::type_identity_t<Int> to,
+                            std::type_identity_t<Int> stride, T identity,
+                            Fn&& fn, Combine&& combine, Policy policy = {})
+    -> std::enable_if_t<std::is_same_v<Policy, per_worker_combine> ||
+                            std::is_same_v<Policy, deterministic_combine>,
+                        T>
+{
+    if (!(from < to))
+    {
+        return identity;
+    }
+
+    std::int64_t const total =
+        static_cast<std::int64_t>(num_iterations(from, to, stride));
+
+    detail::combine_blocks const blocks(total, working_cpu_pool.size(),
+                                        policy);
+
+    std::vector<detail::padded_partial<T>> partials(
+        static_cast<std::size_t>(blocks.size()),
+        detail::padded_partial<T>{identity});
+
+    blocks.for_each(
+        working_cpu_pool,
+        [&](cpu_context const& ctx, std::int64_t b)
+        {
+            T acc = identity;
+            for (auto k = blocks.first(b); k < blocks.last(b); ++k)
+            {
+                Int const idx = from + static_cast<Int>(k) * stride;
+                acc = combine(acc, detail::invoke_loop_body<Int>(fn, ctx, idx));
+            }
+            partials[b].value = acc;
+        });
+
+    T ret = identity;
+    for (auto const& p : partials)
+    {
+        ret = combine(ret, p.value);
+    }
+    return ret;
+}
+
+namespace detail
+{
+
+// Two pass scan.  The first pass reduces every block, the carries into
+// the blocks are then accumulated on the calling thread, and the
+// second pass scans every block starting from its carry.
+template <bool Inclusive, class InputIt, class OutputIt, class T, class Op,
+          class Barrier, class Policy>
+void parallel_scan(basic_cpu_pool<Barrier>& working_cpu_pool, InputIt first,
+                   InputIt last, OutputIt d_first, std::optional<T> init,
+                   Op& op, Policy policy)
+{
+    std::int64_t const total = static_cast<std::int64_t>(last - first);
+
+    if (total <= 0)
+    {
+        return;
+    }
+
+    combine_blocks const blocks(total, working_cpu_pool.size(), policy);
+
+    std::vector<padded_partial<std::optional<T>>> sums(
+        static_cast<std::size_t>(blocks.size()));
+
+    blocks.for_each(working_cpu_pool,
+                    [&](cpu_context const&, std::int64_t b)
+                    {
+                        auto k = blocks.first(b);
+                        if (k == blocks.last(b))
+                        {
+                            return;
+                        }
+
+                        T acc = first[k];
+                        for (++k; k < blocks.last(b); ++k)
+                        {
+                            acc = op(acc, first[k]);
+                        }
+                        sums[b].value = acc;
+                    });
+
+    // The carry into a block replaces its sum; empty blocks pass the
+    // carry on.
+    std::optional<T> carry = init;
+    for (auto& s : sums)
+    {
+        auto sum = std::move(s.value);
+        s.value  = carry;
+        if (sum)
+        {
+            carry = carry ? T(op(*carry, *sum)) : std::move(*sum);
+        }
+    }
+
+    blocks.for_each(working_cpu_pool,
+                    [&](cpu_context const&, std::int64_t b)
+                    {
+                        auto k = blocks.first(b);
+                        if (k == blocks.last(b))
+                        {
+                            return;
+                        }
+
+                        auto const& carry_in = sums[b].value;
+
+                        if constexpr (Inclusive)
+                        {
+                            T acc = carry_in ? T(op(*carry_in, first[k]))
+                                             : T(first[k]);
+                            d_first[k] = acc;
+                            for (++k; k < blocks.last(b); ++k)
+                            {
+                                acc        = op(acc, first[k]);
+                                d_first[k] = acc;
+                            }
+                        }
+                        else
+                        {
+                            T acc = *carry_in;
+                            for (; k < blocks.last(b); ++k)
+                            {
+                                T value    = first[k];
+                                d_first[k] = acc;
+                                acc        = op(acc, value);
+                            }
+                        }
+                    });
+}
+
+} // namespace detail
+
+// Parallel std::inclusive_scan over random access iterators; d_first
+// may be equal to first.  op has to be associative.
+template <class InputIt, class OutputIt, class Op, class Barrier,
+          class Policy = per_worker_combine>
+inline void parallel_inclusive_scan(basic_cpu_pool<Barrier>& working_cpu_pool,
+                                    InputIt first, InputIt last,
+                                    OutputIt d_first, Op op,
+                                    Policy policy = {})
+{
+    using value_type = typename std::iterator_traits<InputIt>::value_type;
+    detail::parallel_scan<true>(working_cpu_pool, first, last, d_first,
+                                std::optional<value_type>(), op, policy);
+}
+
+// Parallel std::exclusive_scan over random access iterators; d_first
+// may be equal to first.  op has to be associative.
+template <class InputIt, class OutputIt, class T, class Op, class Barrier,
+          class Policy = per_worker_combine>
+inline void parallel_exclusive_scan(basic_cpu_pool<Barrier>& working_cpu_pool,
+                                    InputIt first, InputIt last,
+                                    OutputIt d_first, T init, Op op,
+                                    Policy policy = {})
+{
+    detail::parallel_scan<false>(working_cpu_pool, first, last, d_first,
+                                 std::optional<T>(std::move(init)), op,
+                                 policy);
+}
+
+} // namespace sysml::thread
@@ -0,0 +1,229 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/assert.hpp"
+#include "sysml/thread/cpu_set.hpp"
+#include "sysml/thread/topology.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace sysml::thread
+{
+
+// Placement policies for cpu_pool.  Each policy orders the cpus of a
+// topology; a pool of n workers is pinned to the first n of them.
+//
+// A placed pool only uses the cpus in the affinity of the thread that
+// constructs it.  That thread becomes worker 0 and stays pinned until
+// the pool is destroyed, so a second pool placed from the same thread
+// meanwhile sees a single cpu.
+
+// Fill all SMT threads of a core, then the next core of the same L3,
+// NUMA node and package.
+struct compact_placement
+{
+};
+
+// Round-robin across packages; within a package one thread per core
+// first, the SMT siblings only after all the cores are used.
+struct scatter_placement
+{
+};
+
+// A single SMT thread of each physical core, in compact order.
+struct one_per_core_placement
+{
+};
+
+// The cpus of a single NUMA node, in compact order.
+struct numa_node_placement
+{
+    int node = 0;
+};
+
+template <class T>
+struct is_placement
+    : std::bool_constant<std::is_same_v<T, compact_placement> ||
+                         std::is_same_v<T, scatter_placement> ||
+                         std::is_same_v<T, one_per_core_placement> ||
+                         std::is_same_v<T, numa_node_placement>>
+{
+};
+
+template <class T>
+inline constexpr bool is_placement_v = is_placement<T>::value;
+
+namespace detail
+{
+
+// Position of the cpu among its SMT siblings.
+inline std::size_t smt_rank(cpu_info const& c)
+{
+    auto it = std::find(c.smt_siblings.begin(), c.smt_siblings.end(), c.id);
+    return it == c.smt_siblings.end()
+               ? 0
+               : static_cast<std::size_t>(it - c.smt_siblings.begin());
+}
+
+inline std::vector<int> compact_order(std::vector<cpu_info> cpus)
+{
+    std::sort(cpus.begin(), cpus.end(),
+              [](auto const& a, auto const& b)
+              {
+                  return std::tie(a.package, a.numa_node, a.l3_group, a.core,
+                                  a.id) < std::tie(b.package, b.numa_node,
+                                                   b.l3_group, b.core, b.id);
+              });
+
+    std::vector<int> ret;
+    for (auto const& c : cpus)
+    {
+        ret.push_back(c.id);
+    }
+    return ret;
+}
+
+} // namespace detail
+
+inline std::vector<int> placement_order(cpu_topology const& topology,
+                                        compact_placement)
+{
+    return detail::compact_order(topology.cpus());
+}
+
+inline std::vector<int> placement_order(cpu_topology const& topology,
+                                        scatter_placement)
+{
+    std::map<int, std::vector<cpu_info>> per_package;
+    for (auto const& c : topology.cpus())
+    {
+        per_package[c.package].push_back(c);
+    }
+
+    std::vector<std::vector<int>> orders;
+    for (auto& [package, cpus] : per_package)
+    {
+        std::sort(cpus.begin(), cpus.end(),
+                  [](auto const& a, auto const& b)
+                  {
+                      auto ra = detail::smt_rank(a);
+                      auto rb = detail::smt_rank(b);
+                      return std::tie(ra, a.numa_node, a.l3_group, a.core,
+                                      a.id) <
+                             std::tie(rb, b.numa_node, b.l3_group, b.core,
+                                      b.id);
+                  });
+
+        std::vector<int> order;
+        for (auto const& c : cpus)
+        {
+            order.push_back(c.id);
+        }
+        orders.push_back(std::move(order));
+    }
+
+    std::vector<int> ret;
+    for (std::size_t i = 0; ret.size() < topology.size(); ++i)
+    {
+        for (auto const& order : orders)
+        {
+            if (i < order.size())
+            {
+                ret.push_back(order[i]);
+            }
+        }
+    }
+    return ret;
+}
+
+inline std::vector<int> placement_order(cpu_topology const& topology,
+                                        one_per_core_placement)
+{
+    // The first sibling present in the topology represents the core.
+    std::map<int, cpu_info> per_core;
+    for (auto const& c : topology.cpus())
+    {
+        auto it = per_core.find(c.core);
+        if (it == per_core.end() ||
+            detail::smt_rank(c) < detail::smt_rank(it->second))
+        {
+            per_core[c.core] = c;
+        }
+    }
+
+    std::vector<cpu_info> cpus;
+    for (auto const& [core, c] : per_core)
+    {
+        cpus.push_back(c);
+    }
+    return detail::compact_order(std::move(cpus));
+}
+
+inline std::vector<int> placement_order(cpu_topology const&  topology,
+                                        numa_node_placement placement)
+{
+    auto ret = placement_order(
+        topology.subset(topology.cpus_in_numa_node(placement.node)),
+        compact_placement{});
+
+    SYSML_THROW_ASSERT(!ret.empty())
+        << "No cpus in NUMA node " << placement.node;
+
+    return ret;
+}
+
+// The host topology restricted to the cpus the calling thread is
+// allowed to run on.
+inline cpu_topology available_cpu_topology()
+{
+    auto const& host = cpu_topology::host();
+
+    cpu_set allowed;
+    get_affinity(allowed);
+
+    std::vector<int> ids;
+    for (auto id : host.cpu_ids())
+    {
+        if (allowed.is_set(id))
+        {
+            ids.push_back(id);
+        }
+    }
+
+    return ids.empty() ? host : host.subset(ids);
+}
+
+// The cpus for a pool of num_cpus workers.
+template <class Placement>
+auto place_cpus(cpu_topology const& topology, std::size_t num_cpus,
+                Placement placement)
+    -> std::enable_if_t<is_placement_v<Placement>, std::vector<int>>
+{
+    auto ret = placement_order(topology, placement);
+
+    SYSML_THROW_ASSERT(num_cpus > 0 && num_cpus <= ret.size())
+        << "Can't place " << num_cpus << " workers on " << ret.size()
+        << " cpus";
+
+    ret.resize(num_cpus);
+    return ret;
+}
+
+// All the cpus the placement allows.
+template <class Placement>
+auto place_cpus(cpu_topology const& topology, Placement placement)
+    -> std::enable_if_t<is_placement_v<Placement>, std::vector<int>>
+{
+    return placement_order(topology, placement);
+}
+
+} // namespace sysml::thread
@@ -0,0 +1,149 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/assert.hpp"
+#include "sysml/bits/aligned_alloc.hpp"
+#include "sysml/math.hpp"
+#include "sysml/thread/core.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace sysml::thread
+{
+
+// Bump allocator for temporary buffers of a single worker.  Memory is
+// handed out from one contiguous buffer and released all at once by
+// reset().  Allocations that don't fit go to separate overflow blocks;
+// the next allocation after a reset replaces the buffer with one large
+// enough for everything allocated before, so a workload that repeats
+// itself stops allocating after the first round.
+//
+// The buffer is (re)allocated and first touched by the thread that
+// allocates from the arena, so with the kernel's first touch policy
+// its pages end up on that thread's NUMA node.
+class scratch_arena
+{
+public:
+    static constexpr std::size_t default_alignment =
+        hardware_destructive_interference_size;
+
+    static constexpr std::size_t page_size    = 4096;
+    static constexpr std::size_t min_capacity = 1 << 16;
+
+private:
+    std::byte*         buffer_        = nullptr;
+    std::size_t        capacity_      = 0;
+    std::size_t        used_          = 0;
+    std::size_t        overflow_size_ = 0;
+    std::size_t        wanted_        = 0; // Largest total seen so far
+    std::vector<void*> overflow_;
+
+    void replace_buffer(std::size_t capacity)
+    {
+        assert(used_ == 0);
+
+        aligned_free(buffer_);
+        buffer_   = nullptr;
+        capacity_ = 0;
+
+        capacity  = round_up(std::max(capacity, min_capacity), page_size);
+        buffer_   = static_cast<std::byte*>(
+            checked_aligned_allocate(page_size, capacity));
+        capacity_ = capacity;
+    }
+
+public:
+    scratch_arena() = default;
+
+    scratch_arena(scratch_arena const&)            = delete;
+    scratch_arena& operator=(scratch_arena const&) = delete;
+
+    ~scratch_arena()
+    {
+        reset();
+        aligned_free(buffer_);
+    }
+
+    // Makes sure that at least capacity bytes fit in the buffer; has
+    // to be called right after a reset.  The pages are touched.
+    void reserve(std::size_t capacity)
+    {
+        SYSML_STRONG_ASSERT(used_ == 0);
+
+        wanted_ = std::max(wanted_, capacity);
+        if (capacity_ < wanted_)
+        {
+            replace_buffer(wanted_);
+        }
+
+        for (std::size_t i = 0; i < capacity_; i += page_size)
+        {
+            buffer_[i] = std::byte{0};
+        }
+    }
+
+    // alignment has to be a power of two.
+    void* allocate(std::size_t size, std::size_t alignment = default_alignment)
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+        size = std::max(size, std::size_t(1));
+
+        if (used_ == 0 && capacity_ < std::max(wanted_, size))
+        {
+            replace_buffer(std::max(wanted_, size + alignment));
+        }
+
+        std::size_t const offset = round_up(used_, alignment);
+
+        if (offset + size <= capacity_)
+        {
+            used_   = offset + size;
+            wanted_ = std::max(wanted_, used_ + overflow_size_);
+            return buffer_ + offset;
+        }
+
+        void* ret = checked_aligned_allocate(
+            std::max(alignment, default_alignment), size);
+        overflow_.push_back(ret);
+
+        overflow_size_ += size + alignment;
+        wanted_ = std::max(wanted_, used_ + overflow_size_);
+
+        return ret;
+    }
+
+    // Uninitialized storage for n objects of type T; no constructors or
+    // destructors are run.
+    template <class T>
+    T* allocate(std::size_t n, std::size_t alignment = default_alignment)
+    {
+        return static_cast<T*>(
+            allocate(n * sizeof(T), std::max(alignment, alignof(T))));
+    }
+
+    // Releases everything allocated since the last reset.
+    void reset() noexcept
+    {
+        for (auto p : overflow_)
+        {
+            aligned_free(p);
+        }
+        overflow_.clear();
+        overflow_size_ = 0;
+        used_          = 0;
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    std::size_t used() const noexcept { return used_ + overflow_size_; }
+};
+
+} // namespace sysml::thread
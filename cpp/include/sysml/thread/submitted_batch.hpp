@@ -0,0 +1,204 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sysml::thread
+{
+
+struct cpu_context;
+
+// A batch of tasks submitted to a cpu_pool from an arbitrary thread;
+// runs fn(ctx, i) for all i in [first, last).  The callable lives in an
+// inline buffer, so making, copying and queueing batches never
+// allocates.  It has to fit in inline_capacity bytes (capture large
+// state by reference), and be copy constructible, as the workers hand
+// parts of a batch over to each other.
+class submitted_batch
+{
+public:
+    static constexpr std::size_t inline_capacity = 6 * sizeof(void*);
+
+private:
+    enum class operation
+    {
+        copy,
+        move,
+        destroy
+    };
+
+    using invoker_type = void (*)(void const*, cpu_context const&,
+                                  std::size_t, std::size_t);
+    using manager_type = void (*)(operation, void*, void*);
+
+    alignas(std::max_align_t) std::byte storage_[inline_capacity];
+
+    invoker_type invoker_ = nullptr;
+    manager_type manager_ = nullptr;
+    std::size_t  first_   = 0;
+    std::size_t  last_    = 0;
+
+    template <class Fn>
+    static void invoke(void const* fn, cpu_context const& ctx,
+                       std::size_t first, std::size_t last)
+    {
+        auto const& task = *static_cast<Fn const*>(fn);
+        for (std::size_t i = first; i < last; ++i)
+        {
+            task(ctx, i);
+        }
+    }
+
+    template <class Fn>
+    static void manage(operation op, void* dst, void* src)
+    {
+        switch (op)
+        {
+        case operation::copy:
+            ::new (dst) Fn(*static_cast<Fn const*>(src));
+            break;
+        case operation::move:
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            break;
+        case operation::destroy:
+            static_cast<Fn*>(dst)->~Fn();
+            break;
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (manager_ != nullptr)
+        {
+            manager_(operation::destroy, storage_, nullptr);
+        }
+        invoker_ = nullptr;
+        manager_ = nullptr;
+        first_   = 0;
+        last_    = 0;
+    }
+
+    // Both take over other's callable and range; the own callable has
+    // to be gone.
+    void copy_from(submitted_batch const& other)
+    {
+        if (other.manager_ != nullptr)
+        {
+            other.manager_(operation::copy, storage_,
+                           const_cast<std::byte*>(other.storage_));
+        }
+        invoker_ = other.invoker_;
+        manager_ = other.manager_;
+        first_   = other.first_;
+        last_    = other.last_;
+    }
+
+    void move_from(submitted_batch& other) noexcept
+    {
+        if (other.manager_ != nullptr)
+        {
+            other.manager_(operation::move, storage_, other.storage_);
+        }
+        invoker_ = other.invoker_;
+        manager_ = other.manager_;
+        first_   = other.first_;
+        last_    = other.last_;
+        other.reset();
+    }
+
+public:
+    submitted_batch() noexcept = default;
+
+    template <class Fn, class Task = std::decay_t<Fn>,
+              class = std::enable_if_t<
+                  !std::is_same_v<Task, submitted_batch> &&
+                  std::is_invocable_v<Task const&, cpu_context const&,
+                                      std::size_t>>>
+    submitted_batch(Fn&& fn, std::size_t first, std::size_t last)
+        : invoker_(&invoke<Task>)
+        , manager_(&manage<Task>)
+        , first_(first)
+        , last_(last)
+    {
+        static_assert(sizeof(Task) <= inline_capacity,
+                      "Submitted callable too large; capture by reference");
+        static_assert(alignof(Task) <= alignof(std::max_align_t),
+                      "Submitted callable over-aligned");
+        static_assert(std::is_copy_constructible_v<Task>,
+                      "Submitted callable has to be copy constructible");
+        static_assert(std::is_nothrow_move_constructible_v<Task>,
+                      "Submitted callable has to be nothrow movable");
+
+        ::new (static_cast<void*>(storage_)) Task(std::forward<Fn>(fn));
+    }
+
+    submitted_batch(submitted_batch const& other) { copy_from(other); }
+
+    submitted_batch(submitted_batch&& other) noexcept { move_from(other); }
+
+    submitted_batch& operator=(submitted_batch const& other)
+    {
+        if (this != &other)
+        {
+            reset();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    submitted_batch& operator=(submitted_batch&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    ~submitted_batch() { reset(); }
+
+    std::size_t first() const noexcept { return first_; }
+    std::size_t last() const noexcept { return last_; }
+
+    std::size_t size() const noexcept
+    {
+        return first_ < last_ ? last_ - first_ : 0;
+    }
+
+    // A copy running the indices [first, last) of this batch's range.
+    submitted_batch slice(std::size_t first, std::size_t last) const
+    {
+        assert(first_ <= first && first <= last && last <= last_);
+
+        submitted_batch ret(*this);
+        ret.first_ = first;
+        ret.last_  = last;
+        return ret;
+    }
+
+    // Drops the indices from last on.
+    void truncate(std::size_t last) noexcept
+    {
+        assert(first_ <= last && last <= last_);
+        last_ = last;
+    }
+
+    void operator()(cpu_context const& ctx) const
+    {
+        if (invoker_ != nullptr)
+        {
+            invoker_(storage_, ctx, first_, last_);
+        }
+    }
+};
+
+} // namespace sysml::thread
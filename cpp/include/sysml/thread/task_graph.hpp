@@ -0,0 +1,235 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/assert.hpp"
+#include "sysml/thread/core.hpp"
+#include "sysml/thread/cpu_pool.hpp"
+#include "sysml/thread/mpmc_queue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sysml::thread
+{
+
+// A directed acyclic graph of tasks, built once and run any number of
+// times with execute_graph.  Every node is a callable run by a single
+// worker once all the nodes it depends on are done; workers pick up
+// ready nodes as they finish others, instead of meeting at a barrier
+// between stages.  A kernel that should use several workers is split
+// into several nodes.
+//
+// Dependencies are given when a node is added and can only refer to
+// nodes added before, so the graph is acyclic by construction.
+class task_graph
+{
+public:
+    using node_id   = std::uint32_t;
+    using task_type = std::function<void(cpu_context const&)>;
+
+private:
+    static constexpr node_id no_node = std::numeric_limits<node_id>::max();
+
+    struct node
+    {
+        task_type            task;
+        std::vector<node_id> successors;
+        std::uint32_t        num_dependencies = 0;
+    };
+
+    std::vector<node>    nodes_;
+    std::vector<node_id> roots_;
+
+    // Per run state, sized by prepare() when nodes were added since
+    // the last run.
+    std::unique_ptr<std::atomic<std::uint32_t>[]> pending_;
+    std::unique_ptr<mpmc_queue<node_id>>          ready_;
+    std::size_t                                   prepared_size_ = 0;
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::size_t> remaining_{0};
+
+    static std::size_t queue_capacity(std::size_t n)
+    {
+        std::size_t ret = 2;
+        while (ret < n)
+        {
+            ret *= 2;
+        }
+        return ret;
+    }
+
+    void prepare()
+    {
+        if (prepared_size_ != nodes_.size())
+        {
+            pending_ =
+                std::make_unique<std::atomic<std::uint32_t>[]>(nodes_.size());
+            ready_ = std::make_unique<mpmc_queue<node_id>>(
+                queue_capacity(nodes_.size()));
+            prepared_size_ = nodes_.size();
+        }
+
+        for (std::size_t i = 0; i < nodes_.size(); ++i)
+        {
+            pending_[i].store(nodes_[i].num_dependencies,
+                              std::memory_order_relaxed);
+        }
+
+        for (auto r : roots_)
+        {
+            ready_->try_push(r);
+        }
+
+        remaining_.store(nodes_.size(), std::memory_order_relaxed);
+    }
+
+    // Runs ready nodes until all of them are done.  A worker keeps one
+    // of the nodes made ready by the node it just ran for itself, and
+    // queues the others.
+    void work(cpu_context const& ctx)
+    {
+        node_id next = no_node;
+
+        while (remaining_.load(std::memory_order_acquire) > 0)
+        {
+            if (next == no_node)
+            {
+                auto popped = ready_->try_pop();
+                if (!popped)
+                {
+                    DABUN_THREAD_CPU_RELAX();
+                    continue;
+                }
+                next = *popped;
+            }
+
+            auto const& nd = nodes_[std::exchange(next, no_node)];
+
+            nd.task(ctx);
+
+            for (auto s : nd.successors)
+            {
+                if (pending_[s].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    if (next == no_node)
+                    {
+                        next = s;
+                    }
+                    else
+                    {
+                        // Can't fail, every node is queued at most once
+                        // per run.
+                        ready_->try_push(s);
+                    }
+                }
+            }
+
+            remaining_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    template <class Barrier>
+    friend void execute_graph(basic_cpu_pool<Barrier>&, task_graph&);
+
+public:
+    task_graph() = default;
+
+    task_graph(task_graph const&)            = delete;
+    task_graph& operator=(task_graph const&) = delete;
+
+    // Adds a node running fn(ctx) or fn() after all of dependencies
+    // are done; returns its id.
+    template <class Fn>
+    auto add(Fn&& fn, std::vector<node_id> const& dependencies = {})
+        -> std::enable_if_t<std::is_invocable_v<std::decay_t<Fn>&,
+                                                cpu_context const&> ||
+                                std::is_invocable_v<std::decay_t<Fn>&>,
+                            node_id>
+    {
+        SYSML_THROW_ASSERT(nodes_.size() < no_node)
+            << "Too many task graph nodes";
+
+        auto const id = static_cast<node_id>(nodes_.size());
+
+        for (auto d : dependencies)
+        {
+            SYSML_THROW_ASSERT(d < id)
+                << "Node " << id << " depends on unknown node " << d;
+        }
+
+        node nd;
+
+        if constexpr (std::is_invocable_v<std::decay_t<Fn>&,
+                                          cpu_context const&>)
+        {
+            nd.task = std::forward<Fn>(fn);
+        }
+        else
+        {
+            nd.task = [fn = std::forward<Fn>(fn)](cpu_context const&) mutable
+            { fn(); };
+        }
+
+        nd.num_dependencies = static_cast<std::uint32_t>(dependencies.size());
+
+        for (auto d : dependencies)
+        {
+            nodes_[d].successors.push_back(id);
+        }
+
+        if (dependencies.empty())
+        {
+            roots_.push_back(id);
+        }
+
+        nodes_.push_back(std::move(nd));
+
+        return id;
+    }
+
+    std::size_t size() const noexcept { return nodes_.size(); }
+
+    bool empty() const noexcept { return nodes_.empty(); }
+
+    std::vector<node_id> const& successors(node_id id) const
+    {
+        return nodes_.at(id).successors;
+    }
+
+    std::size_t num_dependencies(node_id id) const
+    {
+        return nodes_.at(id).num_dependencies;
+    }
+};
+
+// Runs every node of the graph once, with all the workers of the pool,
+// respecting the dependencies; returns when all are done.  A graph
+// can't be run by two pools at the same time.
+template <class Barrier>
+inline void execute_graph(basic_cpu_pool<Barrier>& working_cpu_pool,
+                          task_graph&              graph)
+{
+    if (graph.empty())
+    {
+        return;
+    }
+
+    graph.prepare();
+
+    working_cpu_pool.execute_on_all_cpus([&graph](cpu_context const& ctx)
+                                         { graph.work(ctx); });
+}
+
+} // namespace sysml::thread
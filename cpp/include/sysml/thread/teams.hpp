@@ -0,0 +1,258 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/assert.hpp"
+#include "sysml/thread/barrier.hpp"
+#include "sysml/thread/cpu_pool.hpp"
+#include "sysml/thread/topology.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace sysml::thread
+{
+
+// What a worker sees while running as a member of a team.  The team
+// barrier only involves the members of the team.
+template <class TeamBarrier>
+struct basic_team_context
+{
+    cpu_context const& cpu;
+    std::size_t        team;      // Index of the team
+    std::size_t        team_rank; // Index of the worker within the team
+    std::size_t        team_size;
+    TeamBarrier&       barrier;
+
+    bool arrive_and_wait() const
+    {
+        return ::sysml::thread::arrive_and_wait(barrier, team_rank);
+    }
+
+    // Split phase, see cpu_context::arrive().
+    auto arrive() const { return ::sysml::thread::arrive(barrier, team_rank); }
+
+    void wait(typename TeamBarrier::arrival_token token) const
+    {
+        barrier.wait(token);
+    }
+};
+
+// A partition of the workers of a cpu_pool into teams, each with its
+// own barrier.  Teams run concurrently within a single execute_teams
+// call and rejoin at its end.
+template <class TeamBarrier = spinning_barrier>
+class basic_cpu_teams
+{
+private:
+    static constexpr std::size_t no_team =
+        std::numeric_limits<std::size_t>::max();
+
+    std::vector<std::vector<std::size_t>>     members_;
+    std::vector<std::size_t>                  team_of_;
+    std::vector<std::size_t>                  rank_of_;
+    std::vector<std::unique_ptr<TeamBarrier>> barriers_;
+
+public:
+    // members[t] lists the workers (pool indices) of team t; every
+    // worker of the pool has to be in exactly one team.
+    explicit basic_cpu_teams(std::vector<std::vector<std::size_t>> members)
+        : members_(std::move(members))
+    {
+        std::size_t num_workers = 0;
+        for (auto const& team : members_)
+        {
+            SYSML_THROW_ASSERT(!team.empty()) << "Empty team";
+            num_workers += team.size();
+        }
+
+        team_of_.assign(num_workers, no_team);
+        rank_of_.assign(num_workers, 0);
+
+        for (std::size_t t = 0; t < members_.size(); ++t)
+        {
+            for (std::size_t r = 0; r < members_[t].size(); ++r)
+            {
+                auto const w = members_[t][r];
+                SYSML_THROW_ASSERT(w < num_workers && team_of_[w] == no_team)
+                    << "Teams are not a partition of the workers, worker "
+                    << w;
+                team_of_[w] = t;
+                rank_of_[w] = r;
+            }
+
+            barriers_.push_back(
+                std::make_unique<TeamBarrier>(members_[t].size()));
+        }
+    }
+
+    // num_teams teams of contiguous workers, of (roughly) equal size.
+    static basic_cpu_teams equal(std::size_t num_workers,
+                                 std::size_t num_teams)
+    {
+        SYSML_THROW_ASSERT(num_teams > 0 && num_teams <= num_workers)
+            << "Can't split " << num_workers << " workers into " << num_teams
+            << " teams";
+
+        std::vector<std::vector<std::size_t>> members(num_teams);
+        for (std::size_t t = 0; t < num_teams; ++t)
+        {
+            for (std::size_t w = num_workers * t / num_teams;
+                 w < num_workers * (t + 1) / num_teams; ++w)
+            {
+                members[t].push_back(w);
+            }
+        }
+        return basic_cpu_teams(std::move(members));
+    }
+
+    // Workers with equal keys[w] form a team; teams are ordered by key.
+    static basic_cpu_teams from_keys(std::vector<int> const& keys)
+    {
+        std::map<int, std::vector<std::size_t>> groups;
+        for (std::size_t w = 0; w < keys.size(); ++w)
+        {
+            groups[keys[w]].push_back(w);
+        }
+
+        std::vector<std::vector<std::size_t>> members;
+        for (auto& [key, team] : groups)
+        {
+            members.push_back(std::move(team));
+        }
+        return basic_cpu_teams(std::move(members));
+    }
+
+    std::size_t size() const noexcept { return members_.size(); }
+
+    std::size_t num_workers() const noexcept { return team_of_.size(); }
+
+    std::vector<std::size_t> const& members(std::size_t team) const
+    {
+        return members_[team];
+    }
+
+    std::size_t team_size(std::size_t team) const
+    {
+        return members_[team].size();
+    }
+
+    std::size_t team_of(std::size_t worker) const { return team_of_[worker]; }
+
+    std::size_t rank_of(std::size_t worker) const { return rank_of_[worker]; }
+
+    TeamBarrier& barrier(std::size_t team) { return *barriers_[team]; }
+};
+
+using cpu_teams    = basic_cpu_teams<>;
+using team_context = basic_team_context<spinning_barrier>;
+
+namespace detail
+{
+
+template <class TeamBarrier, class DispatchBarrier, class Fn>
+basic_cpu_teams<TeamBarrier>
+teams_by_cpu_key(basic_cpu_pool<DispatchBarrier> const& pool,
+                 cpu_topology const& topology, Fn&& key_of)
+{
+    SYSML_THROW_ASSERT(pool.cpu_ids().size() == pool.size())
+        << "Topology based teams need a pool bound to cpus";
+
+    std::vector<int> keys;
+    for (auto cpu : pool.cpu_ids())
+    {
+        keys.push_back(topology.contains(cpu) ? key_of(topology.cpu(cpu))
+                                              : -1);
+    }
+    return basic_cpu_teams<TeamBarrier>::from_keys(keys);
+}
+
+} // namespace detail
+
+// One team per package of the cpus the pool's workers are bound to.
+template <class TeamBarrier = spinning_barrier, class DispatchBarrier>
+basic_cpu_teams<TeamBarrier>
+package_teams(basic_cpu_pool<DispatchBarrier> const& pool,
+              cpu_topology const& topology = cpu_topology::host())
+{
+    return detail::teams_by_cpu_key<TeamBarrier>(
+        pool, topology, [](cpu_info const& c) { return c.package; });
+}
+
+// One team per NUMA node of the cpus the pool's workers are bound to.
+template <class TeamBarrier = spinning_barrier, class DispatchBarrier>
+basic_cpu_teams<TeamBarrier>
+numa_node_teams(basic_cpu_pool<DispatchBarrier> const& pool,
+                cpu_topology const& topology = cpu_topology::host())
+{
+    return detail::teams_by_cpu_key<TeamBarrier>(
+        pool, topology, [](cpu_info const& c) { return c.numa_node; });
+}
+
+// One team per L3 cache of the cpus the pool's workers are bound to.
+template <class TeamBarrier = spinning_barrier, class DispatchBarrier>
+basic_cpu_teams<TeamBarrier>
+l3_group_teams(basic_cpu_pool<DispatchBarrier> const& pool,
+               cpu_topology const& topology = cpu_topology::host())
+{
+    return detail::teams_by_cpu_key<TeamBarrier>(
+        pool, topology, [](cpu_info const& c) { return c.l3_group; });
+}
+
+// Every worker calls fn(team_ctx) with the context of its team; the
+// call returns once all the teams are done.
+template <class Fn, class DispatchBarrier, class TeamBarrier>
+auto execute_teams(basic_cpu_pool<DispatchBarrier>& pool,
+                   basic_cpu_teams<TeamBarrier>& teams, Fn const& fn)
+    -> std::enable_if_t<
+        std::is_invocable_v<Fn const&, basic_team_context<TeamBarrier> const&>>
+{
+    SYSML_THROW_ASSERT(teams.num_workers() == pool.size())
+        << "Teams of " << teams.num_workers() << " workers for a pool of "
+        << pool.size();
+
+    pool.execute_on_all_cpus(
+        [&](cpu_context const& ctx)
+        {
+            auto const team = teams.team_of(ctx.cpu_index);
+            basic_team_context<TeamBarrier> const team_ctx{
+                ctx, team, teams.rank_of(ctx.cpu_index), teams.team_size(team),
+                teams.barrier(team)};
+            fn(team_ctx);
+        });
+}
+
+// Team t runs task_lists[t]; the member with rank r runs the tasks
+// r, r + team_size, ...
+template <class DispatchBarrier, class TeamBarrier>
+void execute_teams(
+    basic_cpu_pool<DispatchBarrier>& pool, basic_cpu_teams<TeamBarrier>& teams,
+    std::vector<std::vector<
+        std::function<void(basic_team_context<TeamBarrier> const&)>>> const&
+        task_lists)
+{
+    SYSML_THROW_ASSERT(task_lists.size() == teams.size())
+        << task_lists.size() << " task lists for " << teams.size()
+        << " teams";
+
+    execute_teams(pool, teams,
+                  [&](basic_team_context<TeamBarrier> const& ctx)
+                  {
+                      auto const& tasks = task_lists[ctx.team];
+                      for (std::size_t i = ctx.team_rank; i < tasks.size();
+                           i += ctx.team_size)
+                      {
+                          tasks[i](ctx);
+                      }
+                  });
+}
+
+} // namespace sysml::thread
@@ -0,0 +1,378 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/assert.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sysml::thread
+{
+
+// Parses the kernel's cpu list format, e.g. "0-3,8,10-11".
+inline std::vector<int> parse_cpu_list(std::string const& list)
+{
+    std::vector<int> ret;
+
+    std::size_t pos = 0;
+    while (pos < list.size())
+    {
+        if (std::isspace(static_cast<unsigned char>(list[pos])) ||
+            list[pos] == ',')
+        {
+            ++pos;
+            continue;
+        }
+
+        std::size_t used  = 0;
+        int         first = std::stoi(list.substr(pos), &used);
+        int         last  = first;
+        pos += used;
+
+        if (pos < list.size() && list[pos] == '-')
+        {
+            ++pos;
+            last = std::stoi(list.substr(pos), &used);
+            pos += used;
+        }
+
+        SYSML_THROW_ASSERT(first >= 0 && first <= last)
+            << "Malformed cpu list: " << list;
+
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            ret.push_back(cpu);
+        }
+    }
+
+    return ret;
+}
+
+struct cpu_info
+{
+    int id;
+    int package;   // physical_package_id
+    int core;      // Smallest id among the SMT siblings of the cpu
+    int numa_node; // NUMA node of the cpu
+    int l2_group;  // Smallest id among the cpus sharing the L2 cache
+    int l3_group;  // Smallest id among the cpus sharing the L3 cache
+
+    std::vector<int> smt_siblings; // Including the cpu itself
+};
+
+// Packages, physical cores, SMT siblings, NUMA nodes and cache sharing
+// groups of the cpus in the system, as reported by
+// /sys/devices/system/cpu.  Entries missing from sysfs fall back to
+// the most conservative value (each cpu is a core of its own, sharing
+// caches with nothing; everything else is in package and node zero).
+class cpu_topology
+{
+private:
+    std::vector<cpu_info>      cpus_;
+    std::map<int, std::size_t> index_of_;
+
+    static bool read_entry(std::filesystem::path const& path, std::string& out)
+    {
+        std::ifstream in(path);
+        return static_cast<bool>(std::getline(in, out));
+    }
+
+    static int read_int(std::filesystem::path const& path, int fallback)
+    {
+        std::string s;
+        if (!read_entry(path, s) || s.empty())
+        {
+            return fallback;
+        }
+        int ret = std::stoi(s);
+        return ret < 0 ? fallback : ret;
+    }
+
+    static std::vector<int> read_cpu_list(std::filesystem::path const& path)
+    {
+        std::string s;
+        return read_entry(path, s) ? parse_cpu_list(s) : std::vector<int>{};
+    }
+
+    static int first_or(std::vector<int> const& v, int fallback)
+    {
+        return v.empty() ? fallback : *std::min_element(v.begin(), v.end());
+    }
+
+    // Whether name is the prefix followed by a number, e.g. "cpu12"
+    static bool is_numbered(std::string const& name, std::string const& prefix)
+    {
+        return name.size() > prefix.size() &&
+               name.compare(0, prefix.size(), prefix) == 0 &&
+               std::all_of(name.begin() + prefix.size(), name.end(),
+                           [](unsigned char c) { return std::isdigit(c); });
+    }
+
+    static std::vector<int> list_cpus(std::filesystem::path const& root)
+    {
+        auto ret = read_cpu_list(root / "online");
+
+        if (ret.empty() && std::filesystem::is_directory(root))
+        {
+            for (auto const& entry : std::filesystem::directory_iterator(root))
+            {
+                auto name = entry.path().filename().string();
+                if (is_numbered(name, "cpu"))
+                {
+                    ret.push_back(std::stoi(name.substr(3)));
+                }
+            }
+        }
+
+        std::sort(ret.begin(), ret.end());
+        return ret;
+    }
+
+    static cpu_info read_cpu(std::filesystem::path const& root, int id)
+    {
+        auto const dir = root / ("cpu" + std::to_string(id));
+
+        cpu_info info{id, 0, id, 0, id, id, {}};
+
+        info.package = read_int(dir / "topology" / "physical_package_id", 0);
+
+        info.smt_siblings = read_cpu_list(dir / "topology" / "core_cpus_list");
+        if (info.smt_siblings.empty())
+        {
+            info.smt_siblings =
+                read_cpu_list(dir / "topology" / "thread_siblings_list");
+        }
+        if (info.smt_siblings.empty())
+        {
+            info.smt_siblings = {id};
+        }
+        info.core = first_or(info.smt_siblings, id);
+
+        info.l2_group = info.core;
+        info.l3_group = info.core;
+
+        if (std::filesystem::is_directory(dir / "cache"))
+        {
+            for (auto const& entry :
+                 std::filesystem::directory_iterator(dir / "cache"))
+            {
+                std::string type;
+                read_entry(entry.path() / "type", type);
+                if (type == "Instruction")
+                {
+                    continue;
+                }
+
+                int  level = read_int(entry.path() / "level", 0);
+                auto group =
+                    first_or(read_cpu_list(entry.path() / "shared_cpu_list"),
+                             info.core);
+
+                if (level == 2)
+                {
+                    info.l2_group = group;
+                }
+                else if (level == 3)
+                {
+                    info.l3_group = group;
+                }
+            }
+        }
+
+        if (std::filesystem::is_directory(dir))
+        {
+            for (auto const& entry : std::filesystem::directory_iterator(dir))
+            {
+                auto name = entry.path().filename().string();
+                if (is_numbered(name, "node"))
+                {
+                    info.numa_node = std::stoi(name.substr(4));
+                }
+            }
+        }
+
+        return info;
+    }
+
+    template <class Fn>
+    std::vector<int> distinct(Fn&& fn) const
+    {
+        std::set<int> s;
+        for (auto const& c : cpus_)
+        {
+            s.insert(fn(c));
+        }
+        return {s.begin(), s.end()};
+    }
+
+    template <class Fn>
+    std::vector<int> select(Fn&& fn) const
+    {
+        std::vector<int> ret;
+        for (auto const& c : cpus_)
+        {
+            if (fn(c))
+            {
+                ret.push_back(c.id);
+            }
+        }
+        return ret;
+    }
+
+public:
+    cpu_topology() = default;
+
+    explicit cpu_topology(std::vector<cpu_info> cpus)
+        : cpus_(std::move(cpus))
+    {
+        std::sort(cpus_.begin(), cpus_.end(),
+                  [](auto const& a, auto const& b) { return a.id < b.id; });
+
+        for (std::size_t i = 0; i < cpus_.size(); ++i)
+        {
+            SYSML_THROW_ASSERT(index_of_.count(cpus_[i].id) == 0)
+                << "Duplicate cpu " << cpus_[i].id;
+            index_of_[cpus_[i].id] = i;
+        }
+    }
+
+    // Reads the topology from a sysfs cpu directory; tests can point
+    // it to a fake tree.
+    static cpu_topology
+    from_sysfs(std::filesystem::path const& root = "/sys/devices/system/cpu")
+    {
+        std::vector<cpu_info> cpus;
+        for (auto id : list_cpus(root))
+        {
+            cpus.push_back(read_cpu(root, id));
+        }
+        return cpu_topology(std::move(cpus));
+    }
+
+    // Every cpu is a core of its own, in a single package and node.
+    static cpu_topology flat(std::size_t num_cpus)
+    {
+        std::vector<cpu_info> cpus;
+        for (int id = 0; id < static_cast<int>(num_cpus); ++id)
+        {
+            cpus.push_back({id, 0, id, 0, id, id, {id}});
+        }
+        return cpu_topology(std::move(cpus));
+    }
+
+    // Topology of this machine, read once.  Falls back to a flat
+    // topology when sysfs is not available.
+    static cpu_topology const& host()
+    {
+        static cpu_topology const ret = []()
+        {
+            auto t = from_sysfs();
+            if (t.size() == 0)
+            {
+                t = flat(std::max(std::thread::hardware_concurrency(), 1u));
+            }
+            return t;
+        }();
+        return ret;
+    }
+
+    std::size_t size() const noexcept { return cpus_.size(); }
+
+    std::vector<cpu_info> const& cpus() const noexcept { return cpus_; }
+
+    bool contains(int cpu) const { return index_of_.count(cpu) > 0; }
+
+    cpu_info const& cpu(int id) const
+    {
+        auto it = index_of_.find(id);
+        SYSML_THROW_ASSERT(it != index_of_.end()) << "Unknown cpu " << id;
+        return cpus_[it->second];
+    }
+
+    std::vector<int> cpu_ids() const
+    {
+        return select([](auto const&) { return true; });
+    }
+
+    std::vector<int> packages() const
+    {
+        return distinct([](auto const& c) { return c.package; });
+    }
+
+    std::vector<int> cores() const
+    {
+        return distinct([](auto const& c) { return c.core; });
+    }
+
+    std::vector<int> numa_nodes() const
+    {
+        return distinct([](auto const& c) { return c.numa_node; });
+    }
+
+    std::vector<int> l2_groups() const
+    {
+        return distinct([](auto const& c) { return c.l2_group; });
+    }
+
+    std::vector<int> l3_groups() const
+    {
+        return distinct([](auto const& c) { return c.l3_group; });
+    }
+
+    std::vector<int> cpus_in_package(int package) const
+    {
+        return select([=](auto const& c) { return c.package == package; });
+    }
+
+    std::vector<int> cpus_in_core(int core) const
+    {
+        return select([=](auto const& c) { return c.core == core; });
+    }
+
+    std::vector<int> cpus_in_numa_node(int node) const
+    {
+        return select([=](auto const& c) { return c.numa_node == node; });
+    }
+
+    std::vector<int> cpus_in_l2_group(int group) const
+    {
+        return select([=](auto const& c) { return c.l2_group == group; });
+    }
+
+    std::vector<int> cpus_in_l3_group(int group) const
+    {
+        return select([=](auto const& c) { return c.l3_group == group; });
+    }
+
+    // The topology restricted to the given cpus; unknown ids are
+    // ignored.  The SMT siblings are not pruned, they still describe
+    // the hardware.
+    cpu_topology subset(std::vector<int> const& ids) const
+    {
+        std::set<int> const   keep(ids.begin(), ids.end());
+        std::vector<cpu_info> cpus;
+        for (auto const& c : cpus_)
+        {
+            if (keep.count(c.id))
+            {
+                cpus.push_back(c);
+            }
+        }
+        return cpu_topology(std::move(cpus));
+    }
+};
+
+} // namespace sysml::thread
@@ -0,0 +1,156 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "sysml/thread/core.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace sysml::thread
+{
+
+// Half open range [begin, end) of iteration numbers.
+struct index_range
+{
+    std::int64_t begin;
+    std::int64_t end;
+
+    std::int64_t size() const noexcept { return end - begin; }
+};
+
+// Bounded Chase-Lev deque of index ranges (see "Correct and Efficient
+// Work-Stealing for Weak Memory Models", Le et al., PPoPP'13).  The
+// owner pushes and pops at the bottom, other threads steal from the
+// top.
+//
+// The deque never grows.  Ranges are split in halves, so the number of
+// pending ranges of a single worker is bounded by the logarithm of the
+// iteration count, which is well within the fixed capacity.  A failed
+// push() simply tells the owner to keep the range for itself.
+class alignas(hardware_destructive_interference_size) work_stealing_deque
+{
+public:
+    static constexpr std::int64_t capacity = 128;
+
+private:
+    static_assert((capacity & (capacity - 1)) == 0,
+                  "capacity has to be a power of two");
+
+    static constexpr std::int64_t mask = capacity - 1;
+
+    // Slots are read by thieves racing with the owner; the individual
+    // fields are atomics so that torn reads are benign (a thief that
+    // read a stale slot will fail the CAS on top_).
+    struct slot
+    {
+        std::atomic<std::int64_t> begin{0};
+        std::atomic<std::int64_t> end{0};
+    };
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::int64_t> top_{0};
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::int64_t> bottom_{0};
+
+    alignas(hardware_destructive_interference_size) slot buffer_[capacity];
+
+public:
+    work_stealing_deque() = default;
+
+    work_stealing_deque(work_stealing_deque const&)            = delete;
+    work_stealing_deque& operator=(work_stealing_deque const&) = delete;
+
+    // Owner only.
+    bool push(index_range r) noexcept
+    {
+        auto b = bottom_.load(std::memory_order_relaxed);
+        auto t = top_.load(std::memory_order_acquire);
+
+        if (b - t >= capacity)
+        {
+            return false;
+        }
+
+        buffer_[b & mask].begin.store(r.begin, std::memory_order_relaxed);
+        buffer_[b & mask].end.store(r.end, std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    // Owner only.
+    std::optional<index_range> pop() noexcept
+    {
+        auto b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) // Empty
+        {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        index_range ret{buffer_[b & mask].begin.load(std::memory_order_relaxed),
+                        buffer_[b & mask].end.load(std::memory_order_relaxed)};
+
+        if (t == b) // Last element, race against the thieves
+        {
+            bool won = top_.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+
+            bottom_.store(b + 1, std::memory_order_relaxed);
+
+            if (!won)
+            {
+                return std::nullopt;
+            }
+        }
+
+        return ret;
+    }
+
+    // Any thread.
+    std::optional<index_range> steal() noexcept
+    {
+        auto t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = bottom_.load(std::memory_order_acquire);
+
+        if (t >= b)
+        {
+            return std::nullopt;
+        }
+
+        index_range ret{buffer_[t & mask].begin.load(std::memory_order_relaxed),
+                        buffer_[t & mask].end.load(std::memory_order_relaxed)};
+
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+        {
+            return std::nullopt;
+        }
+
+        return ret;
+    }
+
+    bool empty() const noexcept
+    {
+        return bottom_.load(std::memory_order_relaxed) <=
+               top_.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace sysml::thread
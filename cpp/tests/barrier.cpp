@@ -0,0 +1,202 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <catch2/catch.hpp>
+
+#include "sysml/thread/barrier.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Every participant bumps a shared counter between barriers; after
+// each barrier all participants have to observe the full count of
+// the previous phase.
+template <class Barrier>
+void check_phases(Barrier& barrier, std::size_t num_threads,
+                  std::size_t num_phases = 200)
+{
+    std::atomic<std::size_t> counter{0};
+    std::atomic<std::size_t> num_last{0};
+    std::atomic<bool>        ok{true};
+
+    auto participant = [&](std::size_t idx)
+    {
+        for (std::size_t phase = 1; phase <= num_phases; ++phase)
+        {
+            counter.fetch_add(1);
+            if (sysml::thread::arrive_and_wait(barrier, idx))
+            {
+                ++num_last;
+            }
+            if (counter.load() < phase * num_threads)
+            {
+                ok = false;
+            }
+            sysml::thread::arrive_and_wait(barrier, idx);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < num_threads; ++i)
+    {
+        threads.emplace_back(participant, i);
+    }
+    participant(0);
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    CHECK(ok.load());
+    CHECK(counter.load() == num_phases * num_threads);
+    CHECK(num_last.load() == num_phases);
+}
+
+// Like check_phases, with the barrier used split phase: participants
+// keep working between arriving and waiting.
+template <class Barrier>
+void check_split_phases(Barrier& barrier, std::size_t num_threads,
+                        std::size_t num_phases = 200)
+{
+    std::atomic<std::size_t> counter{0};
+    std::atomic<bool>        ok{true};
+
+    auto participant = [&](std::size_t idx)
+    {
+        std::size_t local = 0;
+        for (std::size_t phase = 1; phase <= num_phases; ++phase)
+        {
+            counter.fetch_add(1);
+            auto token = sysml::thread::arrive(barrier, idx);
+            local += phase; // Independent work
+            barrier.wait(token);
+            if (counter.load() < phase * num_threads)
+            {
+                ok = false;
+            }
+        }
+        if (local != num_phases * (num_phases + 1) / 2)
+        {
+            ok = false;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < num_threads; ++i)
+    {
+        threads.emplace_back(participant, i);
+    }
+    participant(0);
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    CHECK(ok.load());
+    CHECK(counter.load() == num_phases * num_threads);
+}
+
+} // namespace
+
+TEST_CASE("spinning_barrier", "barrier")
+{
+    sysml::thread::spinning_barrier barrier(3);
+    check_phases(barrier, 3);
+}
+
+TEST_CASE("tree_barrier", "barrier")
+{
+    for (std::size_t n : {1, 2, 3, 5})
+    {
+        sysml::thread::tree_barrier barrier(n, 2);
+        CHECK(barrier.threshold() == n);
+        check_phases(barrier, n);
+    }
+
+    {
+        // Two packages with two L3 domains each, unevenly populated.
+        sysml::thread::tree_barrier barrier(
+            std::vector<std::vector<std::size_t>>{
+                {0, 0}, {0, 0}, {0, 1}, {1, 2}, {1, 2}, {1, 2}},
+            2);
+        CHECK(barrier.threshold() == 6);
+        check_phases(barrier, 6, 50);
+    }
+}
+
+TEST_CASE("hybrid_barrier", "barrier")
+{
+    for (std::size_t n : {1, 2, 3})
+    {
+        sysml::thread::hybrid_barrier barrier(n);
+        check_phases(barrier, n);
+    }
+
+    {
+        // Always parks right away.
+        sysml::thread::hybrid_barrier barrier(3, std::chrono::microseconds(0));
+        CHECK(barrier.current_spin_budget() == 0);
+        check_phases(barrier, 3);
+    }
+
+    {
+        // Long gaps between arrivals shrink the spin budget.
+        sysml::thread::hybrid_barrier barrier(2);
+        auto initial_budget = barrier.current_spin_budget();
+
+        std::thread late(
+            [&]()
+            {
+                for (int i = 0; i < 20; ++i)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    barrier.arrive_and_wait();
+                }
+            });
+
+        for (int i = 0; i < 20; ++i)
+        {
+            barrier.arrive_and_wait();
+        }
+
+        late.join();
+
+        CHECK(barrier.current_spin_budget() < initial_budget);
+    }
+}
+
+TEST_CASE("split_phase_barriers", "barrier")
+{
+    using namespace sysml::thread;
+
+    for (std::size_t n : {1, 2, 4})
+    {
+        spinning_barrier spinning(n);
+        check_split_phases(spinning, n);
+
+        default_barrier deflt(n);
+        check_split_phases(deflt, n);
+
+        tree_barrier tree(n, 2);
+        check_split_phases(tree, n);
+
+        hybrid_barrier hybrid(n);
+        check_split_phases(hybrid, n);
+
+        // Split phase and fused arrivals mix.
+        spinning_barrier mixed(n);
+        check_split_phases(mixed, n, 50);
+        check_phases(mixed, n, 50);
+        check_split_phases(mixed, n, 50);
+    }
+}
@@ -0,0 +1,976 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <catch2/catch.hpp>
+
+#include "sysml/thread/cpu_pool.hpp"
+#include "sysml/thread/parallel_for.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::atomic<std::size_t> allocation_count{0};
+
+void* counted_allocate(std::size_t size, std::size_t alignment) noexcept
+{
+    ++allocation_count;
+    size = size ? size : 1;
+    if (alignment <= alignof(std::max_align_t))
+    {
+        return std::malloc(size);
+    }
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    return std::aligned_alloc(alignment,
+                              (size + alignment - 1) / alignment * alignment);
+}
+
+void* counted_allocate_or_throw(std::size_t size, std::size_t alignment)
+{
+    if (void* ptr = counted_allocate(size, alignment))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+} // namespace
+
+// The replacement operators below pair malloc with free, which GCC can't
+// see through once they are inlined into the standard library code.
+#if defined(__GNUC__) && !defined(__clang__)
+#    pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// Every form of new and delete is replaced, so that whatever the runtime
+// or Catch allocates is released through the same malloc/free pair.
+void* operator new(std::size_t size)
+{
+    return counted_allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size)
+{
+    return counted_allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return counted_allocate_or_throw(size,
+                                     static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return counted_allocate_or_throw(size,
+                                     static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment,
+                   std::nothrow_t const&) noexcept
+{
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment,
+                     std::nothrow_t const&) noexcept
+{
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::nothrow_t const&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::nothrow_t const&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t,
+                     std::nothrow_t const&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t,
+                       std::nothrow_t const&) noexcept
+{
+    std::free(ptr);
+}
+
+TEST_CASE("cpu_pool_execute", "basic")
+{
+    sysml::thread::cpu_pool pool(3);
+
+    std::vector<std::atomic<int>> hits(10);
+
+    // Where each task ran, checked on this thread after the execute.
+    std::vector<std::size_t> ran_on(10);
+
+    auto check_ran_on = [&]()
+    {
+        for (std::size_t i = 0; i < ran_on.size(); ++i)
+        {
+            CHECK(ran_on[i] == i % 3);
+        }
+    };
+
+    std::vector<std::function<void(sysml::thread::cpu_context const&)>> tasks;
+    for (int i = 0; i < 10; ++i)
+    {
+        tasks.push_back(
+            [&hits, &ran_on, i](sysml::thread::cpu_context const& ctx)
+            {
+                ran_on[i] = ctx.cpu_index;
+                ++hits[i];
+            });
+    }
+
+    pool.execute(tasks);
+    check_ran_on();
+
+    ran_on.assign(10, 0);
+    pool.execute(
+        [&](sysml::thread::cpu_context const& ctx, std::size_t i)
+        {
+            ran_on[i] = ctx.cpu_index;
+            ++hits[i];
+        },
+        hits.size());
+    check_ran_on();
+
+    for (auto const& h : hits)
+    {
+        CHECK(h.load() == 2);
+    }
+
+    std::atomic<int> calls{0};
+    pool.execute_on_all_cpus([&](sysml::thread::cpu_context const&)
+                             { ++calls; });
+    CHECK(calls.load() == 3);
+}
+
+TEST_CASE("cpu_pool_execute_allocations", "allocation_free")
+{
+    sysml::thread::cpu_pool pool(3);
+
+    std::atomic<long> sum{0};
+
+    auto body = [&sum](int i) { sum.fetch_add(i); };
+
+    // Warm up anything lazily allocated.
+    sysml::thread::naive_parallel_for(pool, 0, 100, 1, body);
+
+    auto before = allocation_count.load();
+
+    for (int rep = 0; rep < 10; ++rep)
+    {
+        sysml::thread::naive_parallel_for(pool, 0, 100, 1, body);
+        sysml::thread::single_queue_parallel_for(pool, 0, 100, 1, body);
+        pool.execute([&sum](sysml::thread::cpu_context const&,
+                            std::size_t i) { sum.fetch_add(i); },
+                     100);
+    }
+
+    CHECK(allocation_count.load() == before);
+    CHECK(sum.load() == 11 * 4950 + 10 * 4950 + 10 * 4950);
+
+    sum = 0;
+    sysml::thread::naive_parallel_for(pool, 3, 20, 4, body);
+    CHECK(sum.load() == 3 + 7 + 11 + 15 + 19);
+}
+
+TEST_CASE("cpu_pool_tree_barrier", "dispatch_barrier")
+{
+    sysml::thread::basic_cpu_pool<sysml::thread::tree_barrier> pool(4);
+
+    std::vector<std::atomic<int>> hits(100);
+
+    sysml::thread::parallel_for(
+        pool, 0, 100, 1, [&](int i) { ++hits[i]; },
+        sysml::thread::chunked_schedule{8});
+    sysml::thread::naive_parallel_for(pool, 0, 100, 1,
+                                      [&](int i) { ++hits[i]; });
+
+    for (auto const& h : hits)
+    {
+        CHECK(h.load() == 2);
+    }
+
+    // Barrier grouped by the package and L3 of the given cpus
+    sysml::thread::basic_cpu_pool<sysml::thread::tree_barrier> bound_pool(
+        std::vector<int>{0, 0, 0});
+
+    std::atomic<int> calls{0};
+    bound_pool.execute_on_all_cpus([&](sysml::thread::cpu_context const&)
+                                   { ++calls; });
+    CHECK(calls.load() == 3);
+}
+
+TEST_CASE("cpu_pool_hybrid_barrier", "dispatch_barrier")
+{
+    sysml::thread::basic_cpu_pool<sysml::thread::hybrid_barrier> pool(3);
+
+    std::atomic<int> sum{0};
+
+    for (int rep = 0; rep < 10; ++rep)
+    {
+        sysml::thread::naive_parallel_for(pool, 0, 10, 1,
+                                          [&](int i) { sum += i; });
+    }
+
+    CHECK(sum.load() == 450);
+}
+
+TEST_CASE("cpu_pool_placement", "placement")
+{
+    using namespace sysml::thread;
+
+    auto const num_cores =
+        place_cpus(available_cpu_topology(), one_per_core_placement{}).size();
+
+    // A placed pool pins its owner thread until it is destroyed, which
+    // would restrict the placement of the next pool.
+    {
+        cpu_pool pool(1, compact_placement{});
+        CHECK(pool.size() == 1);
+    }
+
+    {
+        cpu_pool per_core_pool{one_per_core_placement{}};
+        CHECK(per_core_pool.size() == num_cores);
+
+        std::atomic<int> calls{0};
+        per_core_pool.execute_on_all_cpus([&](cpu_context const&)
+                                          { ++calls; });
+        CHECK(calls.load() == static_cast<int>(per_core_pool.size()));
+    }
+
+    CHECK_THROWS(cpu_pool(available_cpu_topology().size() + 1,
+                          scatter_placement{}));
+}
+
+TEST_CASE("cpu_pool_execute_async", "async")
+{
+    using namespace sysml::thread;
+
+    for (std::size_t n : {1, 3})
+    {
+        cpu_pool pool(n);
+
+        std::vector<std::atomic<int>> hits(10);
+        std::vector<std::size_t>      ran_on(10);
+
+        auto handle = pool.execute_async(
+            [&](cpu_context const& ctx, std::size_t i)
+            {
+                ran_on[i] = ctx.cpu_index;
+                ++hits[i];
+            },
+            hits.size());
+
+        handle.wait();
+        CHECK(handle.test());
+        CHECK(!handle.valid());
+
+        for (std::size_t i = 0; i < hits.size(); ++i)
+        {
+            CHECK(hits[i].load() == 1);
+            CHECK(ran_on[i] == (n > 1 ? i % (n - 1) + 1 : 0));
+        }
+
+        // The pool is usable again, also after a handle is dropped
+        // without an explicit wait.
+        std::atomic<int> calls{0};
+        {
+            auto on_all = pool.execute_on_all_cpus_async(
+                [&](cpu_context const&) { ++calls; });
+            while (!on_all.test())
+            {
+            }
+        }
+        CHECK(calls.load() == static_cast<int>(n == 1 ? 1 : n - 1));
+
+        pool.execute_on_all_cpus([&](cpu_context const&) { ++calls; });
+        CHECK(calls.load() == static_cast<int>(n == 1 ? 2 : 2 * n - 1));
+
+        // Issuing another execute while one is pending is refused,
+        // also in release builds, and leaves the pool usable.
+        if (n > 1)
+        {
+            auto pending = pool.execute_on_all_cpus_async(
+                [&](cpu_context const&) { ++calls; });
+            CHECK_THROWS(
+                pool.execute_on_all_cpus([](cpu_context const&) {}));
+            CHECK_THROWS(pool.execute_async(
+                [](cpu_context const&, std::size_t) {}, 1));
+            pending.wait();
+            CHECK(calls.load() == static_cast<int>(3 * n - 2));
+        }
+    }
+}
+
+TEST_CASE("cpu_pool_destroy_with_async_pending", "async")
+{
+    using namespace sysml::thread;
+
+    std::atomic<int> calls{0};
+
+    // The pool's destructor finishes the pending execute.
+    {
+        cpu_pool::execute_handle handle;
+        {
+            cpu_pool pool(3);
+            pool.to_serving_mode();
+            handle = pool.execute_async([&](cpu_context const&,
+                                            std::size_t) { ++calls; },
+                                        10);
+        }
+        CHECK(calls.load() == 10);
+
+        // And leaves the handle that outlived it invalid.
+        CHECK(!handle.valid());
+        CHECK(handle.test());
+        handle.wait();
+    }
+
+    // Also when the handle was moved after the execute started.
+    {
+        cpu_pool::execute_handle moved;
+        {
+            cpu_pool pool(2);
+            auto     handle = pool.execute_on_all_cpus_async(
+                [&](cpu_context const&) { ++calls; });
+            moved = std::move(handle);
+            CHECK(!handle.valid());
+            CHECK(moved.valid());
+        }
+        CHECK(calls.load() == 11);
+        CHECK(!moved.valid());
+    }
+}
+
+TEST_CASE("mpmc_queue", "submission")
+{
+    sysml::thread::mpmc_queue<int> queue(4);
+
+    CHECK(queue.empty());
+    for (int i = 0; i < 4; ++i)
+    {
+        CHECK(queue.try_push(i));
+    }
+    CHECK(!queue.try_push(4));
+    CHECK(queue.try_pop() == 0);
+    CHECK(queue.try_push(4));
+    for (int i = 1; i < 5; ++i)
+    {
+        CHECK(queue.try_pop() == i);
+    }
+    CHECK(!queue.try_pop());
+
+    // Concurrent producers and consumers see every element once.
+    sysml::thread::mpmc_queue<int> shared(64);
+    std::atomic<long>              sum{0};
+    std::atomic<int>               popped{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t)
+    {
+        threads.emplace_back(
+            [&, t]()
+            {
+                for (int i = 0; i < 1000; ++i)
+                {
+                    while (!shared.try_push(t * 1000 + i))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        threads.emplace_back(
+            [&]()
+            {
+                while (popped.load() < 2000)
+                {
+                    if (auto v = shared.try_pop())
+                    {
+                        sum += *v;
+                        ++popped;
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    CHECK(sum.load() == 1999L * 2000 / 2);
+}
+
+TEST_CASE("cpu_pool_submit", "submission")
+{
+    using namespace sysml::thread;
+
+    cpu_pool pool(3);
+    pool.to_serving_mode();
+    CHECK(pool.in_serving_mode());
+
+    std::atomic<int> done{0};
+    std::atomic<int> on_owner{0}; // Served on the owner's thread
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 3; ++t)
+    {
+        producers.emplace_back(
+            [&]()
+            {
+                for (int i = 0; i < 100; ++i)
+                {
+                    pool.submit(
+                        [&](cpu_context const& ctx)
+                        {
+                            if (ctx.cpu_index == 0)
+                            {
+                                ++on_owner;
+                            }
+                            ++done;
+                        });
+                }
+            });
+    }
+
+    // Bulk synchronous executes interleave with serving.
+    std::atomic<int> calls{0};
+    pool.execute_on_all_cpus([&](cpu_context const&) { ++calls; });
+    CHECK(calls.load() == 3);
+    CHECK(pool.in_serving_mode());
+
+    for (auto& t : producers)
+    {
+        t.join();
+    }
+
+    while (done.load() < 300)
+    {
+        std::this_thread::yield();
+    }
+    CHECK(on_owner.load() == 0);
+
+    pool.to_sleeping_mode();
+    CHECK(!pool.in_serving_mode());
+    pool.to_serving_mode();
+    pool.set_serving_mode(false);
+
+    // A single worker pool doesn't serve, the owner drains the queue.
+    cpu_pool single(1);
+    std::size_t const capacity = cpu_pool::submission_queue_capacity;
+    for (std::size_t i = 0; i < capacity; ++i)
+    {
+        CHECK(single.try_submit([&](cpu_context const&) { ++done; }));
+    }
+    CHECK(!single.try_submit([&](cpu_context const&) { ++done; }));
+    CHECK(single.run_submitted() == capacity);
+    CHECK(done.load() == 300 + static_cast<int>(capacity));
+
+    // Submitting to a full queue nobody serves: the owner drains it
+    // itself, other threads get an exception instead of waiting
+    // forever.
+    done = 0;
+    for (std::size_t i = 0; i < capacity; ++i)
+    {
+        single.submit([&](cpu_context const&) { ++done; });
+    }
+    single.submit([&](cpu_context const&) { ++done; });
+    CHECK(done.load() == static_cast<int>(capacity));
+
+    // Full again, the last submission is still queued.
+    for (std::size_t i = 1; i < capacity; ++i)
+    {
+        CHECK(single.try_submit([&](cpu_context const&) { ++done; }));
+    }
+
+    bool threw = false;
+    std::thread([&]()
+                {
+                    try
+                    {
+                        single.submit([&](cpu_context const&) { ++done; });
+                    }
+                    catch (std::exception const&)
+                    {
+                        threw = true;
+                    }
+                })
+        .join();
+    CHECK(threw);
+    CHECK(single.run_submitted() == capacity);
+    CHECK(done.load() == 2 * static_cast<int>(capacity));
+}
+
+TEST_CASE("cpu_pool_submit_batches", "submission")
+{
+    using namespace sysml::thread;
+
+    cpu_pool pool(4);
+
+    std::size_t const num_tasks = 1000;
+
+    // Bumped once per index, and where the index ran; checked on this
+    // thread once everything is done.
+    std::vector<std::atomic<int>> hits(2 * num_tasks);
+    std::vector<std::size_t>      ran_on(2 * num_tasks);
+    std::atomic<std::size_t>      done{0};
+
+    auto body = [&](cpu_context const& ctx, std::size_t i)
+    {
+        ran_on[i] = ctx.cpu_index;
+        ++hits[i];
+        ++done;
+    };
+
+    // Warm up anything lazily allocated.
+    pool.to_serving_mode();
+    pool.submit(body, 1);
+    while (done.load() < 1)
+    {
+        std::this_thread::yield();
+    }
+    hits[0] = 0;
+    done    = 0;
+
+    // Started before counting, std::thread allocates its state.
+    std::atomic<bool> go{false};
+
+    std::thread producer(
+        [&]()
+        {
+            while (!go.load())
+            {
+                std::this_thread::yield();
+            }
+            pool.submit([&body](cpu_context const& ctx, std::size_t i)
+                        { body(ctx, num_tasks + i); },
+                        num_tasks);
+        });
+
+    auto before = allocation_count.load();
+    go          = true;
+
+    CHECK(pool.try_submit(body, num_tasks));
+    CHECK(pool.try_submit(body, 0));
+
+    producer.join();
+
+    while (done.load() < 2 * num_tasks)
+    {
+        std::this_thread::yield();
+    }
+
+    pool.set_serving_mode(false);
+
+    CHECK(allocation_count.load() == before);
+
+    for (std::size_t i = 0; i < 2 * num_tasks; ++i)
+    {
+        CHECK(hits[i].load() == 1);
+        CHECK(ran_on[i] != 0);
+    }
+
+    // Run on the owner's thread when not served.
+    done = 0;
+    CHECK(pool.try_submit([&](cpu_context const& ctx, std::size_t i)
+                          { ran_on[i] = ctx.cpu_index + 1; ++done; },
+                          10));
+    CHECK(pool.run_submitted() == 10);
+    CHECK(done.load() == 10);
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+        CHECK(ran_on[i] == 1);
+    }
+}
+
+TEST_CASE("cpu_pool_destroy_in_mode", "submission")
+{
+    using namespace sysml::thread;
+
+    std::atomic<int> done{0};
+
+    // Destroyed while serving; the tasks still queued are run.
+    {
+        cpu_pool pool(2);
+        pool.to_serving_mode();
+        for (int i = 0; i < 10; ++i)
+        {
+            pool.submit([&](cpu_context const&) { ++done; });
+        }
+    }
+    CHECK(done.load() == 10);
+
+    // Destroyed while sleeping.
+    {
+        cpu_pool pool(2);
+        pool.to_sleeping_mode();
+        CHECK(!pool.in_spinning_mode());
+    }
+}
+
+TEST_CASE("scratch_arena", "scratch")
+{
+    sysml::thread::scratch_arena arena;
+
+    auto a = arena.allocate(10);
+    auto b = arena.allocate<double>(3, 256);
+    CHECK(reinterpret_cast<std::uintptr_t>(a) %
+              sysml::thread::scratch_arena::default_alignment ==
+          0);
+    CHECK(reinterpret_cast<std::uintptr_t>(b) % 256 == 0);
+    CHECK(static_cast<void*>(b) != a);
+
+    // Overflows to a separate block, then grows at the next reset.
+    auto big = arena.allocate(arena.capacity());
+    CHECK(big != nullptr);
+    auto const used = arena.used();
+    arena.reset();
+    CHECK(arena.used() == 0);
+    arena.allocate(1);
+    CHECK(arena.capacity() >= used);
+}
+
+TEST_CASE("cpu_pool_scratch", "scratch")
+{
+    using namespace sysml::thread;
+
+    cpu_pool pool(3);
+    pool.reserve_scratch(1 << 20);
+
+    for (std::size_t i = 0; i < pool.size(); ++i)
+    {
+        CHECK(pool.local_scratch(i).capacity() >= (1 << 20));
+        CHECK(pool.local_scratch(i).used() == 0);
+    }
+
+    std::atomic<int> bad_buffers{0};
+
+    auto body = [&](cpu_context const& ctx, std::size_t i)
+    {
+        if (ctx.scratch == nullptr)
+        {
+            ++bad_buffers;
+            return;
+        }
+        auto buf = ctx.scratch->allocate<int>(1000);
+        for (int j = 0; j < 1000; ++j)
+        {
+            buf[j] = static_cast<int>(i) + j;
+        }
+        if (buf[999] != static_cast<int>(i) + 999)
+        {
+            ++bad_buffers;
+        }
+    };
+
+    // Warm up, then the arenas are reused without allocating.
+    pool.execute(body, 30);
+
+    std::vector<std::size_t> capacities;
+    for (std::size_t i = 0; i < pool.size(); ++i)
+    {
+        capacities.push_back(pool.local_scratch(i).capacity());
+    }
+
+    auto before = allocation_count.load();
+    for (int rep = 0; rep < 10; ++rep)
+    {
+        pool.execute(body, 30);
+    }
+    CHECK(allocation_count.load() == before);
+    CHECK(bad_buffers.load() == 0);
+
+    for (std::size_t i = 0; i < pool.size(); ++i)
+    {
+        CHECK(pool.local_scratch(i).used() == 0);
+        CHECK(pool.local_scratch(i).capacity() == capacities[i]);
+    }
+}
+
+TEST_CASE("cpu_pool_counters", "counters")
+{
+    using namespace sysml::thread;
+
+    cpu_pool pool(4);
+
+    pool.reset_counters();
+
+    for (int rep = 0; rep < 10; ++rep)
+    {
+        pool.execute([](cpu_context const&, std::size_t) {}, 40);
+    }
+
+    pool.set_sleeping_mode(true);
+    pool.set_sleeping_mode(false);
+
+    auto counters = pool.counters();
+    REQUIRE(counters.workers.size() == pool.size());
+
+    std::uint64_t tasks = 0;
+    for (auto const& w : counters.workers)
+    {
+        tasks += w.tasks;
+        if constexpr (cpu_pool_counters_enabled)
+        {
+            CHECK(w.dispatches >= 10);
+        }
+        else
+        {
+            CHECK(w.dispatches == 0);
+            CHECK(w.busy_ns == 0);
+            CHECK(w.idle_ns == 0);
+        }
+    }
+
+    if constexpr (cpu_pool_counters_enabled)
+    {
+        CHECK(tasks == 400);
+        CHECK(counters.sleep_transitions == 1);
+        CHECK(counters.wake_transitions == 1);
+        for (std::size_t i = 1; i < pool.size(); ++i)
+        {
+            CHECK(counters.workers[i].sleeps == 1);
+        }
+    }
+    else
+    {
+        CHECK(tasks == 0);
+        CHECK(counters.sleep_transitions == 0);
+    }
+
+    pool.reset_counters();
+    for (auto const& w : pool.counters().workers)
+    {
+        CHECK(w.dispatches == 0);
+        CHECK(w.tasks == 0);
+    }
+}
+
+TEST_CASE("cpu_pool_idle_policy", "idle")
+{
+    using namespace sysml::thread;
+
+    cpu_pool pool(4);
+
+    CHECK(pool.current_idle_policy().spin_time == idle_policy::never_park);
+
+    CHECK_THROWS(pool.set_idle_policy(
+        idle_policy::park_after(std::chrono::microseconds(-1))));
+
+    std::vector<int> hits(64);
+
+    auto body = [&](cpu_context const&, std::size_t i) { ++hits[i]; };
+
+    auto run = [&](int reps)
+    {
+        for (int rep = 0; rep < reps; ++rep)
+        {
+            pool.execute(body, hits.size());
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    };
+
+    pool.reset_counters();
+
+    pool.set_idle_policy(idle_policy::park_after(std::chrono::microseconds(0)));
+    run(10);
+
+    if constexpr (cpu_pool_counters_enabled)
+    {
+        for (std::size_t i = 1; i < pool.size(); ++i)
+        {
+            CHECK(pool.counters().workers[i].sleeps > 0);
+        }
+    }
+
+    pool.set_idle_policy(idle_policy::adaptive_park());
+    CHECK(pool.current_idle_policy().adaptive);
+    run(10);
+
+    // Parked workers still take part in the other modes.
+    pool.set_sleeping_mode(true);
+    run(2);
+    pool.set_sleeping_mode(false);
+
+    pool.to_serving_mode();
+    std::atomic<int> served{0};
+    for (int i = 0; i < 10; ++i)
+    {
+        pool.submit([&](cpu_context const&) { ++served; });
+    }
+    while (served.load() < 10)
+    {
+        std::this_thread::yield();
+    }
+    pool.set_serving_mode(false);
+
+    pool.set_idle_policy(idle_policy::always_spin());
+    run(2);
+
+    for (auto h : hits)
+    {
+        CHECK(h == 24);
+    }
+
+    // The destructor has to wake parked workers.
+    pool.set_idle_policy(idle_policy::park_after(std::chrono::microseconds(0)));
+    pool.execute(body, hits.size());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+TEST_CASE("cpu_pool_serving_idle_policy", "idle")
+{
+    using namespace sysml::thread;
+
+    cpu_pool pool(3);
+    pool.set_idle_policy(idle_policy::park_after(std::chrono::microseconds(0)));
+    pool.to_serving_mode();
+
+    pool.reset_counters();
+
+    // The workers park on the empty queue, and are woken by the
+    // submissions.
+    std::atomic<int> served{0};
+    for (int i = 0; i < 10; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        CHECK(pool.try_submit([&](cpu_context const&) { ++served; }));
+    }
+    while (served.load() < 10)
+    {
+        std::this_thread::yield();
+    }
+
+    if constexpr (cpu_pool_counters_enabled)
+    {
+        std::uint64_t sleeps = 0;
+        for (std::size_t i = 1; i < pool.size(); ++i)
+        {
+            sleeps += pool.counters().workers[i].sleeps;
+        }
+        CHECK(sleeps > 0);
+    }
+
+    // Leaving serving mode wakes the parked workers.
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    pool.set_serving_mode(false);
+
+    pool.to_serving_mode();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+TEST_CASE("cpu_pool_split_phase_barrier", "barrier")
+{
+    using namespace sysml::thread;
+
+    cpu_pool pool(4);
+
+    // Every phase reads the neighbours' values of the previous phase;
+    // the next phase's input is prepared between arrive and wait.
+    std::size_t const      phases = 50;
+    std::vector<long long> values(pool.size(), 1);
+    std::vector<long long> next(pool.size(), 0);
+    std::vector<int>       prepared(pool.size(), 0);
+    std::atomic<int>       no_barrier{0};
+
+    pool.execute_on_all_cpus(
+        [&](cpu_context const& ctx)
+        {
+            // The same for all the workers, so they all leave.
+            if (ctx.barrier == nullptr)
+            {
+                ++no_barrier;
+                return;
+            }
+
+            auto const i = ctx.cpu_index;
+            auto const n = values.size();
+
+            for (std::size_t p = 0; p < phases; ++p)
+            {
+                next[i] = values[(i + n - 1) % n] + values[(i + 1) % n];
+
+                auto token = ctx.arrive();
+                ++prepared[i];
+                ctx.wait(token);
+
+                values[i] = next[i] % 1000003;
+                ctx.arrive_and_wait();
+            }
+        });
+
+    REQUIRE(no_barrier.load() == 0);
+
+    std::vector<long long> expected(pool.size(), 1);
+    for (std::size_t p = 0; p < phases; ++p)
+    {
+        std::vector<long long> tmp(expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            tmp[i] = (expected[(i + expected.size() - 1) % expected.size()] +
+                      expected[(i + 1) % expected.size()]) %
+                     1000003;
+        }
+        expected = tmp;
+    }
+
+    CHECK(values == expected);
+    CHECK(prepared == std::vector<int>(pool.size(), phases));
+}
@@ -0,0 +1,143 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <catch2/catch.hpp>
+
+#include "sysml/thread/cpu_set.hpp"
+
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if !defined(__APPLE__)
+
+TEST_CASE("cpu_set_large_masks", "cpu_set")
+{
+    using sysml::thread::cpu_set;
+
+    cpu_set deflt;
+    CHECK(deflt.capacity() >= CPU_SETSIZE);
+    CHECK(deflt.count() == 0);
+
+    cpu_set large(4096);
+    CHECK(large.capacity() >= 4096);
+    CHECK(large.native_size() >= 4096 / 8);
+
+    large.set(0);
+    large.set(1500);
+    large.set(4095);
+    CHECK(large.count() == 3);
+    CHECK(large.is_set(1500));
+    CHECK(!large.is_set(1501));
+    CHECK(!large.is_set(100000));
+
+    // Setting a cpu beyond the capacity grows the mask.
+    large.set(10000);
+    CHECK(large.capacity() > 10000);
+    CHECK(large.count() == 4);
+    CHECK(large.is_set(4095));
+    CHECK(large.is_set(10000));
+
+    large.clr(10000);
+    large.clr(200000);
+    CHECK(large.count() == 3);
+
+    cpu_set copy = large;
+    CHECK(copy == large);
+    CHECK(copy.native_size() == large.native_size());
+
+    // Equality doesn't depend on the capacities.
+    cpu_set small(64);
+    small.set(3);
+    cpu_set other(8192);
+    other.set(3);
+    CHECK(small == other);
+    other.set(5000);
+    CHECK(!(small == other));
+    small = other;
+    CHECK(small == other);
+
+    cpu_set moved = std::move(copy);
+    CHECK(moved == large);
+
+    // A moved from set is still usable.
+    cpu_set after_move = copy;
+    CHECK(after_move.count() == 0);
+    CHECK(after_move == copy);
+    CHECK(copy.count() == 0);
+    CHECK(!copy.is_set(7));
+    copy.zero();
+    copy.set(7);
+    CHECK(copy.is_set(7));
+
+    other = std::move(small);
+    cpu_set from_assigned = small;
+    CHECK(from_assigned.count() == 0);
+    CHECK(other.is_set(5000));
+
+    cpu_set empty;
+    CHECK(from_assigned == empty);
+    from_assigned = other;
+    CHECK(from_assigned == other);
+
+    // Moving doesn't allocate, so vectors of sets move on reallocation.
+    static_assert(std::is_nothrow_move_constructible_v<cpu_set>);
+    static_assert(std::is_nothrow_move_assignable_v<cpu_set>);
+
+    // Moving a set to itself keeps it.
+    auto& self = other;
+    other      = std::move(self);
+    CHECK(other.is_set(5000));
+}
+
+TEST_CASE("cpu_set_affinity", "cpu_set")
+{
+    using namespace sysml::thread;
+
+    std::thread(
+        []()
+        {
+            cpu_set original;
+            get_affinity(original);
+            REQUIRE(original.count() > 0);
+
+            // A small mask grows to what the kernel needs.
+            cpu_set small(8);
+            get_affinity(small);
+            CHECK(small == original);
+
+            // Masks larger than CPU_SETSIZE are accepted; cpus the
+            // system doesn't have are ignored.
+            cpu_set large(8 * CPU_SETSIZE);
+            large = original;
+            large.set(8 * CPU_SETSIZE - 1);
+            set_affinity(large);
+
+            cpu_set after;
+            get_affinity(after);
+            CHECK(after == original);
+
+            // A moved from set gets a mask again.
+            cpu_set moved = std::move(after);
+            get_affinity(after);
+            CHECK(after == original);
+
+            int first = 0;
+            while (!original.is_set(first))
+            {
+                ++first;
+            }
+
+            bind_to_core(first);
+            get_affinity(after);
+            CHECK(after.count() == 1);
+            CHECK(after.is_set(first));
+
+            set_affinity(original);
+        })
+        .join();
+}
+
+#endif
@@ -0,0 +1,462 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <catch2/catch.hpp>
+
+#include "sysml/measure.hpp"
+#include "sysml/measure/benchmark.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("compute_statistics", "measure")
+{
+    using namespace sysml;
+
+    SECTION("empty")
+    {
+        auto s = compute_statistics({});
+        CHECK(s.count == 0);
+        CHECK(s.mean == 0.0);
+    }
+
+    SECTION("known samples")
+    {
+        auto s = compute_statistics({5, 1, 4, 2, 3}, {true});
+
+        CHECK(s.count == 5);
+        CHECK(s.rejected == 0);
+        CHECK(s.min == 1.0);
+        CHECK(s.max == 5.0);
+        CHECK(s.mean == Approx(3.0));
+        CHECK(s.median == Approx(3.0));
+        CHECK(s.stddev == Approx(1.5811388));
+        CHECK(s.cv == Approx(1.5811388 / 3.0));
+        CHECK(s.p90 == Approx(4.6));
+        CHECK(s.p99 == Approx(4.96));
+        CHECK(s.samples == std::vector<double>{1, 2, 3, 4, 5});
+    }
+
+    SECTION("samples are dropped by default")
+    {
+        auto s = compute_statistics({1, 2});
+        CHECK(s.samples.empty());
+        CHECK(s.median == Approx(1.5));
+    }
+
+    SECTION("single sample")
+    {
+        auto s = compute_statistics({2.5});
+        CHECK(s.min == 2.5);
+        CHECK(s.p999 == 2.5);
+        CHECK(s.stddev == 0.0);
+    }
+
+    SECTION("outlier rejection")
+    {
+        std::vector<double> samples{10, 11, 9, 10, 12, 10, 9, 11, 100};
+
+        auto all = compute_statistics(samples);
+        CHECK(all.count == 9);
+        CHECK(all.max == 100.0);
+
+        auto robust = compute_statistics(samples, {false, 3.5});
+        CHECK(robust.count == 8);
+        CHECK(robust.rejected == 1);
+        CHECK(robust.max == 12.0);
+        CHECK(robust.median == Approx(10.0));
+
+        // Nothing is rejected when the MAD is zero.
+        auto flat = compute_statistics({1, 1, 1, 1, 7}, {false, 3.5});
+        CHECK(flat.rejected == 0);
+        CHECK(flat.max == 7.0);
+    }
+}
+
+TEST_CASE("measure_statistics", "measure")
+{
+    using namespace sysml;
+
+    int  runs = 0;
+    auto s    = measure_statistics([&] { ++runs; }, 20, 3, {true});
+
+    CHECK(runs == 23);
+    CHECK(s.count == 20);
+    CHECK(s.samples.size() == 20);
+    CHECK(s.min <= s.median);
+    CHECK(s.median <= s.p90);
+    CHECK(s.p90 <= s.max);
+
+    auto t = as_time_duration(s);
+    CHECK(t.shortest == s.min);
+    CHECK(t.median == s.median);
+
+    auto f = as_flops(compute_statistics({0.5, 1.0, 2.0}), 4.0);
+    CHECK(f.shortest == Approx(8.0));
+    CHECK(f.median == Approx(4.0));
+}
+
+TEST_CASE("perf_counter_group", "measure")
+{
+    using namespace sysml;
+
+    perf_counter_group group;
+
+    // Counters may not be permitted here; then nothing is counted, but
+    // the time still is.
+    if (!group.available())
+    {
+        CHECK(!group.error().empty());
+        CHECK(group.counters().empty());
+    }
+
+    volatile double x = 1.0;
+
+    auto work = [&]
+    {
+        for (int i = 0; i < 100000; ++i)
+        {
+            x = x * 0.999 + 0.001;
+        }
+    };
+
+    // The counters left in the group are all scheduled.
+    group.start();
+    work();
+    auto const once = group.stop();
+    for (auto c : group.counters())
+    {
+        CHECK(once[c].has_value());
+    }
+
+    auto m = measure_counted(work, group, 10, 1);
+
+    CHECK(m.seconds.count == 10);
+
+    for (auto c : all_perf_counters())
+    {
+        if (!group.has(c))
+        {
+            CHECK(!m.has(c));
+        }
+        CHECK(m[c].count <= 10);
+    }
+
+    if (m.has(perf_counter::instructions))
+    {
+        CHECK(m[perf_counter::instructions].min >= 100000.0);
+    }
+
+    // Duplicates are counted once.
+    perf_counter_group cycles(
+        std::vector<perf_counter>(8, perf_counter::cycles));
+    CHECK(cycles.counters().size() <= 1);
+    cycles.start();
+    work();
+    auto const counts = cycles.stop();
+    CHECK(counts[perf_counter::cycles].has_value() == cycles.available());
+
+    if (m.has(perf_counter::cycles) && m.has(perf_counter::instructions))
+    {
+        CHECK(m.ipc() > 0.0);
+    }
+    else
+    {
+        CHECK(m.ipc() == 0.0);
+    }
+}
+
+template <class Timer>
+void check_timer()
+{
+    using namespace sysml;
+
+    auto const a = Timer::start();
+    auto const b = Timer::stop();
+    CHECK(b >= a);
+
+    double const overhead = timer_overhead_seconds<Timer>();
+    CHECK(overhead >= 0.0);
+    CHECK(overhead < 1e-4);
+
+    auto const sleep = []
+    { std::this_thread::sleep_for(std::chrono::milliseconds(5)); };
+
+    double const t = measure_fastest<Timer>(sleep, 3);
+    CHECK(t >= 4e-3);
+    CHECK(t < 1.0);
+
+    // Nothing takes no time once the overhead is subtracted.
+    CHECK(measure_fastest<Timer>([] {}, 100) < 1e-6);
+}
+
+TEST_CASE("timers", "measure")
+{
+    using namespace sysml;
+
+    check_timer<steady_timer>();
+    check_timer<precise_timer>();
+
+#if defined(SYSML_ON_ARCH_AMD64)
+    if (tsc_timer::supported())
+    {
+        CHECK(precise_timer::use_tsc());
+        CHECK(tsc_timer::frequency() > 1e8);
+        check_timer<tsc_timer>();
+    }
+#endif
+
+    auto [fastest, mean, median] = measure_all<precise_timer>(
+        [] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); },
+        5);
+    CHECK(fastest >= 0.9e-3);
+    CHECK(fastest <= median);
+    CHECK(fastest <= mean);
+
+    auto s = measure_statistics<precise_timer>([] {}, 50, 5);
+    CHECK(s.count == 50);
+    CHECK(s.min >= 0.0);
+}
+
+namespace
+{
+
+int setups = 0;
+
+// The number of cpus test_bench_unbound ran on, outside and inside
+// bench.unbound().
+int bound_cpus   = 0;
+int unbound_cpus = 0;
+
+} // namespace
+
+SYSML_BENCHMARK(test_bench_increment)
+{
+    ++setups;
+
+    int x = 0;
+    bench.set_items(2);
+    bench.measure([&] { ++x; });
+}
+
+SYSML_BENCHMARK(test_bench_no_measure) {}
+
+SYSML_BENCHMARK(test_bench_unbound)
+{
+    sysml::thread::cpu_set affinity;
+
+    sysml::thread::get_affinity(affinity);
+    bound_cpus = affinity.count();
+
+    unbound_cpus = bench.unbound(
+        [&]
+        {
+            sysml::thread::get_affinity(affinity);
+            return affinity.count();
+        });
+
+    bench.measure([] {});
+}
+
+TEST_CASE("benchmark_registry", "measure")
+{
+    using namespace sysml;
+
+    char  arg0[] = "bench";
+    char  arg1[] = "--filter=^test_bench_inc";
+    char  arg2[] = "--repetitions=3";
+    char  arg3[] = "--seconds=0.001";
+    char  arg4[] = "--format=csv";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+
+    auto options = parse_benchmark_options(5, argv);
+    CHECK(options.filter == "^test_bench_inc");
+    CHECK(options.repetitions == 3);
+    CHECK(options.seconds == 0.001);
+    CHECK(options.format == "csv");
+    CHECK(options.cpu == -1);
+
+    auto const selected = selected_benchmarks(options);
+    REQUIRE(selected.size() == 1);
+    CHECK(selected[0].name == "test_bench_increment");
+
+    auto const results = run_benchmarks(options);
+    REQUIRE(results.size() == 1);
+    CHECK(setups == 1);
+    CHECK(results[0].seconds.count == 3);
+    CHECK(results[0].items == 2.0);
+    CHECK(results[0].items_per_second() > 0.0);
+
+    for (std::string format : {"text", "csv", "json"})
+    {
+        std::ostringstream oss;
+        write_benchmark_results(oss, results, format);
+        CHECK(oss.str().find("test_bench_increment") != std::string::npos);
+    }
+
+    std::ostringstream csv;
+    write_benchmark_results(csv, results, "csv");
+    CHECK(csv.str().rfind("name,repetitions,", 0) == 0);
+
+    options.filter = "test_bench_no_measure";
+    CHECK_THROWS(run_benchmarks(options));
+
+    CHECK_THROWS(register_benchmark("test_bench_increment", nullptr));
+
+    char  bad[]      = "--no_such_option";
+    char* bad_argv[] = {arg0, bad};
+    CHECK_THROWS(parse_benchmark_options(2, bad_argv));
+
+    char  precise[]        = "--timer=precise";
+    char  bad_timer[]      = "--timer=sundial";
+    char* timer_argv[]     = {arg0, precise};
+    char* bad_timer_argv[] = {arg0, bad_timer};
+    CHECK(parse_benchmark_options(2, timer_argv).timer == "precise");
+    CHECK_THROWS(parse_benchmark_options(2, bad_timer_argv));
+
+    options.filter = "^test_bench_inc";
+    options.timer  = "precise";
+    CHECK(run_benchmarks(options)[0].seconds.count == 3);
+    options.timer = "steady";
+
+    // --cpu binds the runner for the run, except in unbound().
+    thread::cpu_set original;
+    thread::get_affinity(original);
+
+    options.filter = "test_bench_unbound";
+    options.cpu    = 0;
+    while (!original.is_set(options.cpu))
+    {
+        ++options.cpu;
+    }
+
+    run_benchmarks(options);
+    CHECK(bound_cpus == 1);
+    CHECK(unbound_cpus == original.count());
+
+    thread::cpu_set after;
+    thread::get_affinity(after);
+    CHECK(after == original);
+}
+
+TEST_CASE("mann_whitney_u_test", "measure")
+{
+    using namespace sysml;
+
+    auto const separated = mann_whitney_u_test({1, 2, 3}, {4, 5, 6});
+    CHECK(separated.u == 0.0);
+    CHECK(separated.p_less == Approx(0.0404).margin(1e-3));
+    CHECK(separated.p_greater > 0.9);
+    CHECK(separated.p_two_sided == Approx(2 * separated.p_less));
+
+    auto const swapped = mann_whitney_u_test({4, 5, 6}, {1, 2, 3});
+    CHECK(swapped.u == 9.0);
+    CHECK(swapped.p_greater == Approx(separated.p_less));
+
+    // Ties count half.
+    CHECK(mann_whitney_u_test({1, 2}, {2, 3}).u == 0.5);
+
+    auto const same = mann_whitney_u_test({1, 2, 3, 4}, {1, 2, 3, 4});
+    CHECK(same.u == 8.0);
+    CHECK(same.p_two_sided == 1.0);
+
+    CHECK(mann_whitney_u_test({1, 1}, {1, 1}).p_two_sided == 1.0);
+    CHECK(mann_whitney_u_test({}, {1}).p_two_sided == 1.0);
+
+    // A single outlier doesn't make a regression.
+    std::vector<double> base{10, 11, 12, 10, 11, 12, 10, 11};
+    std::vector<double> noisy{10, 11, 12, 10, 11, 12, 10, 500};
+    CHECK(mann_whitney_u_test(noisy, base).p_two_sided > 0.5);
+}
+
+TEST_CASE("benchmark_baseline", "measure")
+{
+    using namespace sysml;
+
+    std::istringstream json(R"({
+  "benchmarks": [
+    {"name": "slower", "median": 1.0, "samples": [1.0, 1.01, 0.99, 1.02,
+     0.98, 1.0, 1.01, 0.99]},
+    {"name": "faster", "samples": [1e-3, 1.1e-3, 0.9e-3, 1e-3, 1.05e-3,
+     0.95e-3, 1e-3, 1e-3]},
+    {"name": "same", "samples": [2, 2.1, 1.9, 2, 2.05, 1.95, 2, 2]},
+    {"name": "gone \"old\"", "samples": [1]},
+    {"name": "other_gone", "samples": [1]},
+    {"name": "no_samples", "median": 1.0}
+  ]
+})");
+
+    auto const baseline = read_benchmark_baseline(json);
+    REQUIRE(baseline.size() == 5);
+    CHECK(baseline[0].name == "slower");
+    CHECK(baseline[0].samples.size() == 8);
+    CHECK(baseline[1].samples[1] == 1.1e-3);
+    CHECK(baseline[3].name == "gone \"old\"");
+
+    auto const make_result =
+        [](std::string name, std::vector<double> samples, double scale)
+    {
+        for (auto& s : samples)
+        {
+            s *= scale;
+        }
+        benchmark_result ret;
+        ret.name    = std::move(name);
+        ret.seconds = compute_statistics(std::move(samples), {true});
+        return ret;
+    };
+
+    std::vector<benchmark_result> results{
+        make_result("slower", baseline[0].samples, 1.5),
+        make_result("faster", baseline[1].samples, 0.5),
+        make_result("same", baseline[2].samples, 1.01),
+        make_result("brand_new", {1, 2, 3}, 1.0)};
+
+    benchmark_options options;
+    options.filter = "^[a-z_]+$"; // Leaves out "gone \"old\""
+
+    auto const cs = compare_benchmarks(baseline, results, options);
+    REQUIRE(cs.size() == 5);
+
+    CHECK(cs[0].verdict == benchmark_verdict::regression);
+    CHECK(cs[0].change == Approx(0.5));
+    CHECK(cs[0].p_value < 0.01);
+    CHECK(cs[1].verdict == benchmark_verdict::improvement);
+    CHECK(cs[2].verdict == benchmark_verdict::unchanged);
+    CHECK(cs[3].verdict == benchmark_verdict::added);
+    CHECK(cs[4].name == "other_gone");
+    CHECK(cs[4].verdict == benchmark_verdict::missing);
+
+    CHECK(has_regressions(cs));
+
+    // A slowdown below the threshold isn't a regression.
+    options.threshold = 0.6;
+    CHECK(!has_regressions(compare_benchmarks(baseline, results, options)));
+
+    for (std::string format : {"text", "csv", "json"})
+    {
+        std::ostringstream oss;
+        write_benchmark_comparison(oss, cs, format);
+        CHECK(oss.str().find("regression") != std::string::npos);
+    }
+
+    // Results written as json read back as a baseline.
+    std::ostringstream written;
+    write_benchmark_results(written, results, "json");
+    std::istringstream read_back(written.str());
+
+    auto const round_trip = read_benchmark_baseline(read_back);
+    REQUIRE(round_trip.size() == results.size());
+    CHECK(round_trip[0].name == "slower");
+    CHECK(round_trip[0].samples.size() == 8);
+    CHECK(round_trip[0].samples[0] ==
+          Approx(results[0].seconds.samples[0]).epsilon(1e-6));
+
+    std::istringstream malformed(R"({"name": 1})");
+    CHECK_THROWS(read_benchmark_baseline(malformed));
+}
@@ -67,6 +67,23 @@ TEST_CASE("ndarray", "[single-file]")
     }
 }
 
+TEST_CASE("ndarray-large", "[single-file]")
+{
+    // Well over the allocation padding, which used to be all the room
+    // arrays larger than their element count in bytes got.
+    sysml::ndarray<double, 2> a({64u, 33u});
+
+    int idx = 0;
+    for (std::size_t i = 0; i < 64; ++i)
+        for (std::size_t j = 0; j < 33; ++j)
+            a[i][j] = idx++;
+
+    idx = 0;
+    for (std::size_t i = 0; i < 64; ++i)
+        for (std::size_t j = 0; j < 33; ++j)
+            CHECK(a[i][j] == idx++);
+}
+
 TEST_CASE("ndarray-descriptor", "[single-file]")
 {
     using namespace sysml::ndarray_detail;
@@ -0,0 +1,225 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <catch2/catch.hpp>
+
+#include "sysml/thread/parallel_for.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+TEST_CASE("parallel_for_dynamic", "work_stealing")
+{
+    sysml::thread::cpu_pool pool(3);
+
+    for (int grain : {1, 3, 64})
+    {
+        std::vector<std::atomic<int>> hits(1000);
+
+        sysml::thread::parallel_for_dynamic(
+            pool, 0, 1000, 1, [&](int i) { ++hits[i]; }, grain);
+
+        for (auto const& h : hits)
+        {
+            CHECK(h.load() == 1);
+        }
+    }
+
+    {
+        std::vector<std::atomic<int>> hits(100);
+        std::atomic<int>              bad_index{0};
+
+        // Catch2's assertions aren't thread-safe; the workers only
+        // record what the test thread checks.
+        sysml::thread::parallel_for_dynamic(
+            pool, 5, 100, 7,
+            [&](sysml::thread::cpu_context const& ctx, int i)
+            {
+                if (ctx.cpu_index >= pool.size())
+                {
+                    ++bad_index;
+                }
+                ++hits[i];
+            });
+
+        CHECK(bad_index.load() == 0);
+        for (int i = 0; i < 100; ++i)
+        {
+            CHECK(hits[i].load() == ((i >= 5 && (i - 5) % 7 == 0) ? 1 : 0));
+        }
+    }
+
+    {
+        int calls = 0;
+        sysml::thread::parallel_for_dynamic(pool, 10, 10, 1,
+                                            [&](int) { ++calls; });
+        CHECK(calls == 0);
+    }
+}
+
+TEST_CASE("work_stealing_deque", "basic")
+{
+    sysml::thread::work_stealing_deque d;
+
+    CHECK(d.empty());
+    CHECK(!d.pop());
+    CHECK(!d.steal());
+
+    CHECK(d.push({0, 4}));
+    CHECK(d.push({4, 8}));
+
+    auto stolen = d.steal();
+    REQUIRE(stolen);
+    CHECK(stolen->begin == 0);
+
+    auto popped = d.pop();
+    REQUIRE(popped);
+    CHECK(popped->begin == 4);
+    CHECK(d.empty());
+
+    for (std::int64_t i = 0; i < sysml::thread::work_stealing_deque::capacity;
+         ++i)
+    {
+        CHECK(d.push({i, i + 1}));
+    }
+    CHECK(!d.push({0, 1}));
+}
+
+TEMPLATE_TEST_CASE("parallel_for_schedules", "schedule",
+                   sysml::thread::static_block_schedule,
+                   sysml::thread::chunked_schedule,
+                   sysml::thread::guided_schedule,
+                   sysml::thread::dynamic_schedule,
+                   sysml::thread::affinity_schedule)
+{
+    sysml::thread::cpu_pool pool(3);
+
+    for (int n : {0, 1, 2, 17, 1000})
+    {
+        std::vector<std::atomic<int>> hits(2 * n + 3);
+
+        sysml::thread::parallel_for(
+            pool, 3, 2 * n + 3, 2, [&](int i) { ++hits[i]; }, TestType{});
+
+        for (int i = 0; i < 2 * n + 3; ++i)
+        {
+            CHECK(hits[i].load() == ((i >= 3 && i % 2 == 1) ? 1 : 0));
+        }
+    }
+}
+
+TEST_CASE("parallel_for_schedule_parameters", "schedule")
+{
+    sysml::thread::cpu_pool pool(2);
+
+    std::vector<std::atomic<int>> hits(1000);
+
+    sysml::thread::parallel_for(
+        pool, 0, 1000, 1, [&](int i) { ++hits[i]; },
+        sysml::thread::chunked_schedule{64});
+    sysml::thread::parallel_for(
+        pool, 0, 1000, 1,
+        [&](sysml::thread::cpu_context const&, int i) { ++hits[i]; },
+        sysml::thread::guided_schedule{16});
+
+    for (auto const& h : hits)
+    {
+        CHECK(h.load() == 2);
+    }
+}
+
+TEST_CASE("parallel_for_affinity_schedule", "schedule")
+{
+    using namespace sysml::thread;
+
+    cpu_pool      pool(4);
+    loop_affinity affinity(4);
+
+    std::vector<std::atomic<int>> hits(1000);
+    std::vector<std::size_t>      ran_on(1000);
+
+    auto body = [&](cpu_context const& ctx, int i)
+    {
+        ++hits[i];
+        ran_on[i] = ctx.cpu_index;
+    };
+
+    for (int rep = 1; rep <= 10; ++rep)
+    {
+        parallel_for(pool, 0, 1000, 1, body, affinity_schedule{&affinity});
+
+        REQUIRE(affinity.num_chunks() == 16);
+
+        // The handle knows who ran each chunk.
+        for (std::size_t c = 0; c < affinity.num_chunks(); ++c)
+        {
+            for (auto i = affinity.first(c); i < affinity.last(c); ++i)
+            {
+                CHECK(ran_on[i] == affinity.owner(c));
+            }
+        }
+    }
+
+    for (auto const& h : hits)
+    {
+        CHECK(h.load() == 10);
+    }
+
+    // A different iteration count starts over with contiguous blocks.
+    parallel_for(pool, 0, 8, 1, body, affinity_schedule{&affinity});
+    CHECK(affinity.num_chunks() == 8);
+    CHECK(affinity.last(7) == 8);
+
+    // A single worker runs everything.
+    cpu_pool      single(1);
+    loop_affinity single_affinity;
+    parallel_for(single, 0, 100, 1, body,
+                 affinity_schedule{&single_affinity});
+    for (std::size_t c = 0; c < single_affinity.num_chunks(); ++c)
+    {
+        CHECK(single_affinity.owner(c) == 0);
+    }
+}
+
+TEST_CASE("loop_affinity", "schedule")
+{
+    using sysml::thread::loop_affinity;
+
+    loop_affinity affinity(2);
+
+    std::vector<std::int64_t> chunks;
+    auto record = [&](std::int64_t first, std::int64_t)
+    { chunks.push_back(first); };
+
+    // Worker 0 runs its own chunks, then steals all of worker 1's,
+    // from the far end.
+    affinity.prepare(40, 2);
+    affinity.run(0, record);
+    affinity.run(1, record);
+    affinity.finish();
+
+    CHECK(chunks == std::vector<std::int64_t>{0, 10, 30, 20});
+    for (std::size_t c = 0; c < affinity.num_chunks(); ++c)
+    {
+        CHECK(affinity.owner(c) == 0);
+    }
+
+    // Worker 1 has nothing of its own left, and steals everything back.
+    affinity.prepare(40, 2);
+    affinity.run(1, [&](std::int64_t, std::int64_t) {});
+    affinity.finish();
+    for (std::size_t c = 0; c < affinity.num_chunks(); ++c)
+    {
+        CHECK(affinity.owner(c) == 1);
+    }
+
+    // Now they are all its own, run in order.
+    chunks.clear();
+    affinity.prepare(40, 2);
+    affinity.run(1, record);
+    affinity.finish();
+    CHECK(chunks == std::vector<std::int64_t>{0, 10, 20, 30});
+}
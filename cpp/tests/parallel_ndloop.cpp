@@ -0,0 +1,79 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <catch2/catch.hpp>
+
+#include "sysml/thread/parallel_ndloop.hpp"
+
+#include <atomic>
+#include <vector>
+
+TEST_CASE("parallel_ndloop", "ndloop")
+{
+    using namespace sysml;
+
+    thread::cpu_pool pool(3);
+
+    std::vector<std::atomic<int>> hits(5 * 7 * 9);
+
+    auto at = [&](int i, int j, int k) -> std::atomic<int>&
+    { return hits[(i * 7 + j) * 9 + k]; };
+
+    vek<int, 3> begin{1, 0, 2};
+    vek<int, 3> end{5, 7, 9};
+    vek<int, 3> tile{2, 3, 4};
+
+    thread::parallel_ndloop(pool, begin, end, tile,
+                            [&](vek<int, 3> const& v)
+                            { ++at(v[0], v[1], v[2]); });
+
+    thread::parallel_ndloop(
+        pool, begin, end, tile, [&](int i, int j, int k) { ++at(i, j, k); },
+        thread::chunked_schedule{2});
+
+    for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < 7; ++j)
+            for (int k = 0; k < 9; ++k)
+                CHECK(at(i, j, k).load() == (i >= 1 && k >= 2 ? 2 : 0));
+
+    // 2 x 3 x 2 tiles, clipped at the upper boundaries.
+    std::atomic<int> tiles{0};
+    std::atomic<int> points{0};
+    std::atomic<int> bad_tiles{0};
+
+    thread::parallel_ndloop_tiles(
+        pool, begin, end, tile,
+        [&](thread::cpu_context const& ctx, vek<int, 3> const& first,
+            vek<int, 3> const& last)
+        {
+            bool ok = ctx.cpu_index < pool.size();
+            for (std::size_t d = 0; d < 3; ++d)
+            {
+                ok = ok && first[d] < last[d] &&
+                     last[d] - first[d] <= tile[d] && last[d] <= end[d];
+            }
+            if (!ok)
+            {
+                ++bad_tiles;
+            }
+            ++tiles;
+            points += (last[0] - first[0]) * (last[1] - first[1]) *
+                      (last[2] - first[2]);
+        },
+        thread::dynamic_schedule{1});
+
+    CHECK(bad_tiles.load() == 0);
+    CHECK(tiles.load() == 12);
+    CHECK(points.load() == 4 * 7 * 7);
+
+    // Empty box
+    thread::parallel_ndloop_tiles(pool, end, begin, tile,
+                                  [&](vek<int, 3> const&, vek<int, 3> const&)
+                                  { ++tiles; });
+    CHECK(tiles.load() == 12);
+
+    CHECK_THROWS(thread::parallel_ndloop(pool, begin, end, vek<int, 3>{1, 0, 1},
+                                         [](vek<int, 3> const&) {}));
+}
@@ -0,0 +1,125 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <catch2/catch.hpp>
+
+#include "sysml/thread/parallel_reduce.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+TEST_CASE("parallel_reduce", "reduce")
+{
+    sysml::thread::cpu_pool pool(3);
+
+    auto sum = sysml::thread::parallel_reduce(
+        pool, 0, 1000, 1, std::int64_t(0),
+        [](int i) { return static_cast<std::int64_t>(i); }, std::plus<>());
+    CHECK(sum == 999 * 1000 / 2);
+
+    std::atomic<int> bad_index{0};
+
+    auto strided = sysml::thread::parallel_reduce(
+        pool, 3, 20, 4, 0,
+        [&](sysml::thread::cpu_context const& ctx, int i)
+        {
+            if (ctx.cpu_index >= pool.size())
+            {
+                ++bad_index;
+            }
+            return i;
+        },
+        std::plus<>(), sysml::thread::deterministic_combine{2});
+    CHECK(strided == 3 + 7 + 11 + 15 + 19);
+    CHECK(bad_index.load() == 0);
+
+    // Fewer iterations than workers, and none at all.
+    CHECK(sysml::thread::parallel_reduce(
+              pool, 0, 2, 1, 1, [](int i) { return i + 2; },
+              std::multiplies<>()) == 6);
+    CHECK(sysml::thread::parallel_reduce(
+              pool, 5, 5, 1, 42, [](int i) { return i; }, std::plus<>()) ==
+          42);
+}
+
+TEST_CASE("parallel_reduce_deterministic", "reduce")
+{
+    std::vector<float> data(10000);
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = 1.f / static_cast<float>(i + 1);
+    }
+
+    auto reduce = [&](std::size_t threads)
+    {
+        sysml::thread::cpu_pool pool(threads);
+        return sysml::thread::parallel_reduce(
+            pool, std::size_t(0), data.size(), 1, 0.f,
+            [&](std::size_t i) { return data[i]; }, std::plus<>(),
+            sysml::thread::deterministic_combine{128});
+    };
+
+    auto const expected = reduce(1);
+    for (std::size_t threads : {2, 3, 4})
+    {
+        CHECK(reduce(threads) == expected);
+    }
+}
+
+TEST_CASE("parallel_scan", "scan")
+{
+    sysml::thread::cpu_pool pool(3);
+
+    for (std::size_t n : {0, 1, 2, 5, 1000})
+    {
+        std::vector<int> in(n);
+        std::iota(in.begin(), in.end(), 1);
+
+        std::vector<int> expected(n);
+        std::vector<int> out(n);
+
+        std::inclusive_scan(in.begin(), in.end(), expected.begin());
+        sysml::thread::parallel_inclusive_scan(pool, in.begin(), in.end(),
+                                               out.begin(), std::plus<>());
+        CHECK(out == expected);
+
+        std::exclusive_scan(in.begin(), in.end(), expected.begin(), 10);
+        sysml::thread::parallel_exclusive_scan(
+            pool, in.begin(), in.end(), out.begin(), 10, std::plus<>(),
+            sysml::thread::deterministic_combine{7});
+        CHECK(out == expected);
+
+        // In place
+        std::inclusive_scan(in.begin(), in.end(), expected.begin());
+        sysml::thread::parallel_inclusive_scan(
+            pool, in.begin(), in.end(), in.begin(), std::plus<>(),
+            sysml::thread::deterministic_combine{16});
+        CHECK(in == expected);
+    }
+
+    // Bit-identical across thread counts with a deterministic combine.
+    std::vector<double> data(5000);
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = 1.0 / static_cast<double>(i + 1);
+    }
+
+    auto scan = [&](std::size_t threads)
+    {
+        sysml::thread::cpu_pool pool(threads);
+        std::vector<double>     out(data.size());
+        sysml::thread::parallel_inclusive_scan(
+            pool, data.begin(), data.end(), out.begin(), std::plus<>(),
+            sysml::thread::deterministic_combine{64});
+        return out;
+    };
+
+    auto const expected = scan(1);
+    CHECK(scan(2) == expected);
+    CHECK(scan(4) == expected);
+}
@@ -0,0 +1,132 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <catch2/catch.hpp>
+
+#include "sysml/thread/task_graph.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+TEST_CASE("task_graph_build", "task_graph")
+{
+    using namespace sysml::thread;
+
+    task_graph graph;
+    CHECK(graph.empty());
+
+    auto a = graph.add([] {});
+    auto b = graph.add([](cpu_context const&) {}, {a});
+    auto c = graph.add([] {}, {a});
+    auto d = graph.add([] {}, {b, c});
+
+    CHECK(graph.size() == 4);
+    CHECK(graph.successors(a) == std::vector<task_graph::node_id>{b, c});
+    CHECK(graph.num_dependencies(d) == 2);
+    CHECK(graph.num_dependencies(a) == 0);
+
+    CHECK_THROWS(graph.add([] {}, {d + 1}));
+    CHECK(graph.size() == 4);
+}
+
+TEST_CASE("execute_graph", "task_graph")
+{
+    using namespace sysml::thread;
+
+    std::size_t const num_nodes = 500;
+
+    // Random DAG; every node records the order in which it finished
+    // and checks that its dependencies finished before it started.
+    std::mt19937                       rng(42);
+    std::vector<std::atomic<int>>      finished(num_nodes);
+    std::atomic<int>                   clock{0};
+    std::atomic<int>                   violations{0};
+    std::vector<std::vector<unsigned>> dependencies(num_nodes);
+
+    task_graph graph;
+
+    for (std::size_t i = 0; i < num_nodes; ++i)
+    {
+        if (i > 0)
+        {
+            std::uniform_int_distribution<unsigned> pick(0, i - 1);
+            for (int k = rng() % 4; k > 0; --k)
+            {
+                dependencies[i].push_back(pick(rng));
+            }
+        }
+
+        graph.add(
+            [&, i](cpu_context const&)
+            {
+                for (auto d : dependencies[i])
+                {
+                    if (finished[d].load() == 0)
+                    {
+                        ++violations;
+                    }
+                }
+                finished[i].store(++clock);
+            },
+            {dependencies[i].begin(), dependencies[i].end()});
+    }
+
+    for (std::size_t threads : {1, 2, 4})
+    {
+        cpu_pool pool(threads);
+
+        for (int rep = 0; rep < 5; ++rep)
+        {
+            for (auto& f : finished)
+            {
+                f = 0;
+            }
+            clock = 0;
+
+            execute_graph(pool, graph);
+
+            CHECK(clock.load() == static_cast<int>(num_nodes));
+            CHECK(violations.load() == 0);
+        }
+    }
+
+    // Nodes added after a run are picked up by the next one.
+    std::atomic<int> extra{0};
+    graph.add([&] { ++extra; }, {0, 1});
+
+    cpu_pool pool(3);
+    execute_graph(pool, graph);
+    CHECK(extra.load() == 1);
+
+    task_graph empty;
+    execute_graph(pool, empty);
+}
+
+TEST_CASE("execute_graph_chain", "task_graph")
+{
+    using namespace sysml::thread;
+
+    cpu_pool pool(4);
+
+    // A chain has no parallelism; the order is fixed.
+    std::vector<int> order;
+    task_graph       graph;
+
+    task_graph::node_id prev = graph.add([&] { order.push_back(0); });
+    for (int i = 1; i < 100; ++i)
+    {
+        prev = graph.add([&, i] { order.push_back(i); }, {prev});
+    }
+
+    execute_graph(pool, graph);
+
+    REQUIRE(order.size() == 100);
+    for (int i = 0; i < 100; ++i)
+    {
+        CHECK(order[i] == i);
+    }
+}
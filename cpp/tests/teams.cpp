@@ -0,0 +1,155 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <catch2/catch.hpp>
+
+#include "sysml/thread/teams.hpp"
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+TEST_CASE("cpu_teams_partition", "teams")
+{
+    using sysml::thread::cpu_teams;
+
+    auto teams = cpu_teams::equal(5, 2);
+    REQUIRE(teams.size() == 2);
+    CHECK(teams.members(0) == std::vector<std::size_t>{0, 1});
+    CHECK(teams.members(1) == std::vector<std::size_t>{2, 3, 4});
+    CHECK(teams.team_of(3) == 1);
+    CHECK(teams.rank_of(3) == 1);
+
+    auto keyed = cpu_teams::from_keys({7, 3, 7, 3, 3});
+    REQUIRE(keyed.size() == 2);
+    CHECK(keyed.members(0) == std::vector<std::size_t>{1, 3, 4});
+    CHECK(keyed.members(1) == std::vector<std::size_t>{0, 2});
+
+    CHECK_THROWS(cpu_teams::equal(2, 3));
+    CHECK_THROWS(cpu_teams({{0, 1}, {1}}));
+    CHECK_THROWS(cpu_teams({{0, 1}, {}}));
+}
+
+TEST_CASE("execute_teams", "teams")
+{
+    using namespace sysml::thread;
+
+    cpu_pool pool(4);
+    auto     teams = cpu_teams::equal(pool.size(), 2);
+
+    // Each team runs its own number of phases, synchronizing only on
+    // the team barrier.
+    std::vector<std::atomic<int>> phase_sums(2);
+
+    // Counted on the workers, checked here.
+    std::atomic<int> bad_contexts{0};
+    std::atomic<int> bad_sums{0};
+
+    execute_teams(pool, teams,
+                  [&](team_context const& ctx)
+                  {
+                      if (ctx.team != teams.team_of(ctx.cpu.cpu_index) ||
+                          ctx.team_size != 2)
+                      {
+                          ++bad_contexts;
+                      }
+
+                      int const phases = ctx.team == 0 ? 10 : 100;
+                      for (int p = 0; p < phases; ++p)
+                      {
+                          int const expected =
+                              static_cast<int>(ctx.team_size) * p * (p + 1) / 2;
+
+                          phase_sums[ctx.team] += p;
+                          ctx.arrive_and_wait();
+                          if (phase_sums[ctx.team].load() != expected)
+                          {
+                              ++bad_sums;
+                          }
+                          ctx.arrive_and_wait();
+                      }
+                  });
+
+    CHECK(bad_contexts.load() == 0);
+    CHECK(bad_sums.load() == 0);
+    CHECK(phase_sums[0].load() == 2 * 45);
+    CHECK(phase_sums[1].load() == 2 * 4950);
+
+    std::vector<std::atomic<int>> hits(7);
+    std::vector<std::size_t>      ran_in(7); // The team of each task
+
+    std::vector<std::vector<std::function<void(team_context const&)>>> lists(
+        2);
+    for (int i = 0; i < 7; ++i)
+    {
+        lists[i < 3 ? 0 : 1].push_back(
+            [&hits, &ran_in, i](team_context const& ctx)
+            {
+                ran_in[i] = ctx.team;
+                ++hits[i];
+            });
+    }
+
+    execute_teams(pool, teams, lists);
+
+    for (int i = 0; i < 7; ++i)
+    {
+        CHECK(hits[i].load() == 1);
+        CHECK(ran_in[i] == (i < 3 ? 0u : 1u));
+    }
+
+    auto wrong = cpu_teams::equal(3, 1);
+    CHECK_THROWS(execute_teams(pool, wrong, [](team_context const&) {}));
+}
+
+TEST_CASE("topology_teams", "teams")
+{
+    using namespace sysml::thread;
+
+    // Only cpu 0 is known to be available, so all the workers share it.
+    cpu_topology topology({{0, 0, 0, 0, 0, 0, {0}}, {1, 1, 1, 1, 1, 1, {1}}});
+
+    cpu_pool pool(std::vector<int>{0, 0, 0, 0});
+    CHECK(pool.cpu_ids() == std::vector<int>{0, 0, 0, 0});
+    CHECK(package_teams(pool, topology).size() == 1);
+
+    cpu_pool unbound(2);
+    CHECK(unbound.cpu_ids().empty());
+    CHECK_THROWS(package_teams(unbound, topology));
+
+    CHECK(numa_node_teams(pool).size() == 1);
+    CHECK(l3_group_teams(pool).size() == 1);
+}
+
+TEST_CASE("execute_teams_split_phase", "teams")
+{
+    using namespace sysml::thread;
+
+    cpu_pool pool(4);
+    auto     teams = cpu_teams::equal(pool.size(), 2);
+
+    std::vector<std::atomic<int>> arrivals(2);
+    std::atomic<int>              bad{0};
+
+    execute_teams(pool, teams,
+                  [&](team_context const& ctx)
+                  {
+                      for (int p = 1; p <= 20; ++p)
+                      {
+                          ++arrivals[ctx.team];
+                          auto token = ctx.arrive();
+                          ctx.wait(token);
+                          if (arrivals[ctx.team].load() <
+                              p * static_cast<int>(ctx.team_size))
+                          {
+                              ++bad;
+                          }
+                      }
+                  });
+
+    CHECK(bad.load() == 0);
+    CHECK(arrivals[0].load() == 40);
+    CHECK(arrivals[1].load() == 40);
+}
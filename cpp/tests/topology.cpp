@@ -0,0 +1,178 @@
+// Copyright (c) Meta Platforms, Inc. and affiliates. All Rights Reserved.
+//
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <catch2/catch.hpp>
+
+#include "sysml/thread/placement.hpp"
+#include "sysml/thread/topology.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+namespace fs = std::filesystem;
+
+void write_file(fs::path const& path, std::string const& content)
+{
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << content << "\n";
+}
+
+// Two packages (each its own NUMA node and L3), two cores per package,
+// two SMT threads per core (cpu N and N + 4 are siblings), private L2
+// per core.
+fs::path make_fake_sysfs()
+{
+    auto root = fs::temp_directory_path() / "sysml_fake_sysfs_cpu";
+    fs::remove_all(root);
+
+    write_file(root / "online", "0-7");
+
+    for (int cpu = 0; cpu < 8; ++cpu)
+    {
+        int  core    = cpu % 4;
+        int  package = core / 2;
+        auto dir     = root / ("cpu" + std::to_string(cpu));
+
+        write_file(dir / "topology" / "physical_package_id",
+                   std::to_string(package));
+        write_file(dir / "topology" / "core_id", std::to_string(core % 2));
+        write_file(dir / "topology" / "thread_siblings_list",
+                   std::to_string(core) + "," + std::to_string(core + 4));
+
+        write_file(dir / "cache" / "index0" / "level", "1");
+        write_file(dir / "cache" / "index0" / "type", "Data");
+        write_file(dir / "cache" / "index0" / "shared_cpu_list",
+                   std::to_string(core) + "," + std::to_string(core + 4));
+
+        write_file(dir / "cache" / "index1" / "level", "1");
+        write_file(dir / "cache" / "index1" / "type", "Instruction");
+        write_file(dir / "cache" / "index1" / "shared_cpu_list", "0-7");
+
+        write_file(dir / "cache" / "index2" / "level", "2");
+        write_file(dir / "cache" / "index2" / "type", "Unified");
+        write_file(dir / "cache" / "index2" / "shared_cpu_list",
+                   std::to_string(core) + "," + std::to_string(core + 4));
+
+        write_file(dir / "cache" / "index3" / "level", "3");
+        write_file(dir / "cache" / "index3" / "type", "Unified");
+        write_file(dir / "cache" / "index3" / "shared_cpu_list",
+                   package == 0 ? "0-1,4-5" : "2-3,6-7");
+
+        fs::create_directories(dir / ("node" + std::to_string(package)));
+    }
+
+    return root;
+}
+
+} // namespace
+
+TEST_CASE("parse_cpu_list", "topology")
+{
+    using sysml::thread::parse_cpu_list;
+
+    CHECK(parse_cpu_list("0") == std::vector<int>{0});
+    CHECK(parse_cpu_list("0-3,8,10-11\n") ==
+          std::vector<int>{0, 1, 2, 3, 8, 10, 11});
+    CHECK(parse_cpu_list("").empty());
+    CHECK_THROWS(parse_cpu_list("3-1"));
+}
+
+TEST_CASE("cpu_topology_from_fake_sysfs", "topology")
+{
+    auto root     = make_fake_sysfs();
+    auto topology = sysml::thread::cpu_topology::from_sysfs(root);
+
+    REQUIRE(topology.size() == 8);
+
+    CHECK(topology.packages() == std::vector<int>{0, 1});
+    CHECK(topology.numa_nodes() == std::vector<int>{0, 1});
+    CHECK(topology.cores() == std::vector<int>{0, 1, 2, 3});
+    CHECK(topology.l2_groups() == std::vector<int>{0, 1, 2, 3});
+    CHECK(topology.l3_groups() == std::vector<int>{0, 2});
+
+    CHECK(topology.cpus_in_package(1) == std::vector<int>{2, 3, 6, 7});
+    CHECK(topology.cpus_in_numa_node(0) == std::vector<int>{0, 1, 4, 5});
+    CHECK(topology.cpus_in_core(1) == std::vector<int>{1, 5});
+    CHECK(topology.cpus_in_l3_group(2) == std::vector<int>{2, 3, 6, 7});
+
+    auto const& cpu6 = topology.cpu(6);
+    CHECK(cpu6.package == 1);
+    CHECK(cpu6.core == 2);
+    CHECK(cpu6.numa_node == 1);
+    CHECK(cpu6.l2_group == 2);
+    CHECK(cpu6.l3_group == 2);
+    CHECK(cpu6.smt_siblings == std::vector<int>{2, 6});
+
+    CHECK(!topology.contains(8));
+    CHECK_THROWS(topology.cpu(8));
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("cpu_topology_fallbacks", "topology")
+{
+    auto root = fs::temp_directory_path() / "sysml_fake_sysfs_sparse";
+    fs::remove_all(root);
+
+    // No online file, no topology or cache information.
+    fs::create_directories(root / "cpu0");
+    fs::create_directories(root / "cpu1");
+    fs::create_directories(root / "cpufreq");
+
+    auto topology = sysml::thread::cpu_topology::from_sysfs(root);
+
+    CHECK(topology.cpu_ids() == std::vector<int>{0, 1});
+    CHECK(topology.cores() == std::vector<int>{0, 1});
+    CHECK(topology.packages() == std::vector<int>{0});
+    CHECK(topology.numa_nodes() == std::vector<int>{0});
+
+    fs::remove_all(root);
+
+    CHECK(sysml::thread::cpu_topology::from_sysfs(root).size() == 0);
+    CHECK(sysml::thread::cpu_topology::host().size() > 0);
+}
+
+TEST_CASE("placement_policies", "topology")
+{
+    using namespace sysml::thread;
+
+    auto root     = make_fake_sysfs();
+    auto topology = cpu_topology::from_sysfs(root);
+
+    CHECK(place_cpus(topology, compact_placement{}) ==
+          std::vector<int>{0, 4, 1, 5, 2, 6, 3, 7});
+    CHECK(place_cpus(topology, scatter_placement{}) ==
+          std::vector<int>{0, 2, 1, 3, 4, 6, 5, 7});
+    CHECK(place_cpus(topology, one_per_core_placement{}) ==
+          std::vector<int>{0, 1, 2, 3});
+    CHECK(place_cpus(topology, numa_node_placement{1}) ==
+          std::vector<int>{2, 6, 3, 7});
+
+    CHECK(place_cpus(topology, 3, compact_placement{}) ==
+          std::vector<int>{0, 4, 1});
+    CHECK(place_cpus(topology, 2, scatter_placement{}) ==
+          std::vector<int>{0, 2});
+
+    CHECK_THROWS(place_cpus(topology, 5, one_per_core_placement{}));
+    CHECK_THROWS(place_cpus(topology, 0, compact_placement{}));
+    CHECK_THROWS(place_cpus(topology, numa_node_placement{2}));
+
+    // Restricted to the cpus 1, 2 and 5, core 1 is represented by cpu 1.
+    auto restricted = topology.subset({5, 2, 1, 42});
+    CHECK(restricted.cpu_ids() == std::vector<int>{1, 2, 5});
+    CHECK(place_cpus(restricted, one_per_core_placement{}) ==
+          std::vector<int>{1, 2});
+    CHECK(place_cpus(restricted, scatter_placement{}) ==
+          std::vector<int>{1, 2, 5});
+
+    fs::remove_all(root);
+
+    CHECK(available_cpu_topology().size() > 0);
+}